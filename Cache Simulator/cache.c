@@ -0,0 +1,619 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * A set associative cache. Each set keeps its lines in
+ * a doubly linked recency list, with the invalid lines
+ * at the LRU end, so hits, fills, and removals take
+ * constant time and LRU and FIFO victims are at hand.
+ * Other replacement policies pick victims themselves.
+ * Sets with more than TAG_SCAN_MAX lines find tags
+ * through a per-set hash table instead of scanning.
+ * Stores mark lines dirty in write-back caches, and
+ * what reaches the next level is counted in bytes.
+ * Prefetched lines stay marked until they are used.
+ * A line is one word of tag and flags, so a tag check
+ * is a single compare, and with AVX2 or SSE4.1 the tags
+ * of a set are compared 4 or 2 at a time.
+ ********************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+/* What fill_line found in the line it replaced */
+#define EVICTED_VALID  1
+#define EVICTED_DIRTY  2
+#define EVICTED_UNUSED 4
+
+/* Function - tag_slot
+ * Home slot of a line word (without its status flags) in the
+ * lookup table of a set.
+ * */
+static inline int tag_slot(struct cache *cache, unsigned long word){
+    return (int)((word * 0x9e3779b97f4a7c15UL) >> 32) &
+           (cache->tag_table_size-1);
+}
+
+/* Function - scan_set
+ * Comparing the words of a set without their status flags to
+ * a line word. The vector loops handle 4 (AVX2) or 2 (SSE4.1)
+ * lines per compare and leave the rest to the scalar one.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Lines of the set, E and the word of the tag looked for.
+ * --------------------------------------------------
+ * Return value:
+ * Index of the line holding the tag, or -1 if none does.
+ * --------------------------------------------------
+ * */
+static inline int scan_set(const unsigned long *current_set,
+                           int number_of_lines, unsigned long word){
+    int j = 0;
+#if defined(__AVX2__)
+    const __m256i keep = _mm256_set1_epi64x((long)~LINE_STATUS);
+    const __m256i wanted = _mm256_set1_epi64x((long)word);
+    int mask;
+
+    for (; j + 4 <= number_of_lines; j += 4) {
+        __m256i tags = _mm256_loadu_si256((const __m256i *)(current_set + j));
+        tags = _mm256_cmpeq_epi64(_mm256_and_si256(tags, keep), wanted);
+        mask = _mm256_movemask_pd(_mm256_castsi256_pd(tags));
+        if (mask != 0)
+            return j + __builtin_ctz(mask);
+    }
+#elif defined(__SSE4_1__)
+    const __m128i keep = _mm_set1_epi64x((long)~LINE_STATUS);
+    const __m128i wanted = _mm_set1_epi64x((long)word);
+    int mask;
+
+    for (; j + 2 <= number_of_lines; j += 2) {
+        __m128i tags = _mm_loadu_si128((const __m128i *)(current_set + j));
+        tags = _mm_cmpeq_epi64(_mm_and_si128(tags, keep), wanted);
+        mask = _mm_movemask_pd(_mm_castsi128_pd(tags));
+        if (mask != 0)
+            return j + __builtin_ctz(mask);
+    }
+#endif
+    for (; j < number_of_lines; j++) {
+        if ((current_set[j] & ~LINE_STATUS) == word)
+            return j;
+    }
+    return -1;
+}
+
+/* Function - find_line
+ * Looking up the line holding a tag in a set. Small sets are
+ * scanned, larger ones use their slice of tag_table, which holds
+ * line index + 1 (0 for an empty slot) with linear probing.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache, set number and tag.
+ * --------------------------------------------------
+ * Return value:
+ * Index of the line within the set, or -1 on a miss.
+ * --------------------------------------------------
+ * */
+static int find_line(struct cache *cache, unsigned long set_number,
+                     unsigned long tag_number){
+    unsigned long *current_set =
+        cache->lines + set_number*cache->number_of_lines;
+    unsigned long word = LINE_WORD(tag_number);
+    int slot;
+    int *table;
+
+    if (cache->tag_table_size == 0)
+        return scan_set(current_set, cache->number_of_lines, word);
+
+    table = cache->tag_table + set_number*cache->tag_table_size;
+    for (slot = tag_slot(cache, word); table[slot] != 0;
+         slot = (slot+1) & (cache->tag_table_size-1)) {
+        if ((current_set[table[slot]-1] & ~LINE_STATUS) == word)
+            return table[slot]-1;
+    }
+    return -1;
+}
+
+/* Function - tag_insert
+ * Recording that line 'j' of a set now holds its tag.
+ * */
+static void tag_insert(struct cache *cache, unsigned long set_number,
+                       int j){
+    unsigned long *current_set =
+        cache->lines + set_number*cache->number_of_lines;
+    int *table = cache->tag_table + set_number*cache->tag_table_size;
+    int slot = tag_slot(cache, current_set[j] & ~LINE_STATUS);
+
+    while (table[slot] != 0)
+        slot = (slot+1) & (cache->tag_table_size-1);
+    table[slot] = j+1;
+}
+
+/* Function - tag_remove
+ * Dropping the tag of line 'j' from the lookup table of a set. The
+ * entries after it in the probe run are shifted back, so lookups
+ * never need tombstones.
+ * */
+static void tag_remove(struct cache *cache, unsigned long set_number,
+                       int j){
+    unsigned long *current_set =
+        cache->lines + set_number*cache->number_of_lines;
+    int *table = cache->tag_table + set_number*cache->tag_table_size;
+    int mask = cache->tag_table_size-1;
+    int hole = tag_slot(cache, current_set[j] & ~LINE_STATUS);
+    int slot;
+    int home;
+
+    while (table[hole] != j+1)
+        hole = (hole+1) & mask;
+    for (slot = (hole+1) & mask; table[slot] != 0; slot = (slot+1) & mask) {
+        home = tag_slot(cache, current_set[table[slot]-1] & ~LINE_STATUS);
+        // Move the entry unless its home lies cyclically in (hole, slot]
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            table[hole] = table[slot];
+            hole = slot;
+        }
+    }
+    table[hole] = 0;
+}
+
+/* Function - unlink_line
+ * Taking line 'j' out of the recency list of its set.
+ * */
+static void unlink_line(struct cache_link* current_set,
+                        struct cache_set* set, int j){
+    struct cache_link *line = current_set + j;
+
+    if (line->prev >= 0)
+        current_set[line->prev].next = line->next;
+    else
+        set->mru = line->next;
+    if (line->next >= 0)
+        current_set[line->next].prev = line->prev;
+    else
+        set->lru = line->prev;
+}
+
+/* Function - make_mru
+ * Moving line 'j' of a set to the front of its recency list.
+ * */
+static void make_mru(struct cache_link* current_set,
+                     struct cache_set* set, int j){
+    struct cache_link *line = current_set + j;
+
+    if (set->mru == j)
+        return;
+    unlink_line(current_set, set, j);
+    line->prev = -1;
+    line->next = set->mru;
+    if (set->mru >= 0)
+        current_set[set->mru].prev = j;
+    else
+        set->lru = j;
+    set->mru = j;
+}
+
+/* Function - make_lru
+ * Moving line 'j' of a set to the back of its recency list.
+ * */
+static void make_lru(struct cache_link* current_set,
+                     struct cache_set* set, int j){
+    struct cache_link *line = current_set + j;
+
+    if (set->lru == j)
+        return;
+    unlink_line(current_set, set, j);
+    line->next = -1;
+    line->prev = set->lru;
+    if (set->lru >= 0)
+        current_set[set->lru].next = j;
+    else
+        set->mru = j;
+    set->lru = j;
+}
+
+/* Function - cache_init
+ * Allocating a cache of 2^s sets of E lines each, with all
+ * lines invalid and linked into their set's recency list.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Cache to set up, s, E, b and replacement policy.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if the memory couldn't be allocated.
+ * --------------------------------------------------
+ * */
+int cache_init(struct cache *cache, int set_bits, int number_of_lines,
+               int block_bits, const struct replacement_policy *policy){
+    unsigned long number_of_sets = 1UL << set_bits;
+    unsigned long i;
+    int j;
+
+    cache->set_bits = set_bits;
+    cache->number_of_lines = number_of_lines;
+    cache->block_bits = block_bits;
+    cache->policy = policy;
+    cache->write_back = 1;
+    cache->write_allocate = 1;
+    memset(&cache->counts, 0, sizeof(cache->counts));
+    cache->tag_table_size = 0;
+    if (number_of_lines > TAG_SCAN_MAX) {
+        // Lookup table at most half full, rounded up to a power of 2.
+        for (cache->tag_table_size = 1;
+             cache->tag_table_size < 2*number_of_lines; )
+            cache->tag_table_size <<= 1;
+    }
+
+    // The sizes below would wrap around for arrays that don't fit in
+    // size_t, and the loop at the end would write past them.
+    if (number_of_sets > SIZE_MAX / sizeof(struct cache_set) ||
+        number_of_sets > SIZE_MAX / number_of_lines /
+                         sizeof(struct cache_link) ||
+        number_of_sets > SIZE_MAX / number_of_lines / sizeof(unsigned long) ||
+        (cache->tag_table_size > 0 &&
+         number_of_sets > (SIZE_MAX - 1) / cache->tag_table_size /
+                          sizeof(int))) {
+        cache->lines = NULL;
+        cache->links = NULL;
+        cache->state = NULL;
+        cache->sets = NULL;
+        cache->tag_table = NULL;
+        return -1;
+    }
+
+    // Zeroed, so all lines start out invalid.
+    cache->lines = calloc(number_of_sets*number_of_lines,
+                          sizeof(unsigned long));
+    cache->links = malloc(number_of_sets*number_of_lines*
+                          sizeof(struct cache_link));
+    cache->state = NULL;
+    if (policy->hit != NULL || policy->fill != NULL)
+        cache->state = calloc(number_of_sets*number_of_lines,
+                              sizeof(unsigned));
+    cache->sets = malloc(number_of_sets*sizeof(struct cache_set));
+    cache->tag_table = calloc(number_of_sets*cache->tag_table_size + 1,
+                              sizeof(int));
+    if (cache->lines == NULL || cache->links == NULL ||
+        cache->sets == NULL || cache->tag_table == NULL ||
+        (cache->state == NULL &&
+         (policy->hit != NULL || policy->fill != NULL))) {
+        cache_free(cache);
+        return -1;
+    }
+
+    for (i = 0; i < number_of_sets; i++) {
+        struct cache_link *current_set = cache->links + i*number_of_lines;
+        for (j = 0; j < number_of_lines; j++) {
+            current_set[j].prev = j-1;
+            current_set[j].next = (j+1 < number_of_lines) ? j+1 : -1;
+        }
+        cache->sets[i].mru = 0;
+        cache->sets[i].lru = number_of_lines-1;
+        cache->sets[i].random_state = (i+1) * 0x9e3779b97f4a7c15UL;
+    }
+    return 0;
+}
+
+/* Function - cache_free
+ * Releasing the memory of a cache.
+ * */
+void cache_free(struct cache *cache){
+    free(cache->lines);
+    free(cache->links);
+    free(cache->state);
+    free(cache->sets);
+    free(cache->tag_table);
+    cache->lines = NULL;
+    cache->links = NULL;
+    cache->state = NULL;
+    cache->sets = NULL;
+    cache->tag_table = NULL;
+}
+
+/* Function - touch_line
+ * Looking a tag up in a set and telling the replacement
+ * policy about a hit. The line becomes MRU unless the list
+ * is kept in fill order.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache, set number and tag.
+ * --------------------------------------------------
+ * Return value:
+ * Index of the line within the set on a hit, -1 on a miss.
+ * --------------------------------------------------
+ * */
+static inline int touch_line(struct cache *cache, unsigned long set_number,
+                             unsigned long tag_number){
+    int j = find_line(cache, set_number, tag_number);
+
+    if (j < 0)
+        return -1;
+    if (!cache->policy->fill_order)
+        make_mru(cache->links + set_number*cache->number_of_lines,
+                 cache->sets + set_number, j);
+    if (cache->policy->hit != NULL)
+        cache->policy->hit(cache, set_number, j);
+    return j;
+}
+
+/* Function - fill_line
+ * Filling a line of a set with a tag, which becomes MRU.
+ * The LRU line is an invalid one as long as the set has
+ * any, otherwise the replacement policy picks the victim.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache, set number, a tag that isn't cached,
+ * whether the new line starts out dirty or prefetched and
+ * where to store the tag of the evicted block.
+ * --------------------------------------------------
+ * Return value:
+ * 0 if no valid block was evicted, EVICTED_VALID otherwise,
+ * with EVICTED_DIRTY and EVICTED_UNUSED (a prefetched
+ * block that was never used) added.
+ * --------------------------------------------------
+ * */
+static inline int fill_line(struct cache *cache, unsigned long set_number,
+                            unsigned long tag_number, int dirty,
+                            int prefetched, unsigned long *victim_tag){
+    unsigned long *current_set =
+        cache->lines + set_number*cache->number_of_lines;
+    struct cache_set *set = cache->sets + set_number;
+    int j = set->lru;
+    int evicted = (current_set[j] & LINE_VALID) != 0;
+
+    if (evicted) {
+        j = cache->policy->victim(cache, set_number);
+        *victim_tag = LINE_TAG(current_set[j]);
+        if (current_set[j] & LINE_DIRTY)
+            evicted |= EVICTED_DIRTY;
+        if (current_set[j] & LINE_PREFETCHED)
+            evicted |= EVICTED_UNUSED;
+        if (cache->tag_table_size != 0)
+            tag_remove(cache, set_number, j);
+    }
+    current_set[j] = LINE_WORD(tag_number) |
+                     (dirty ? LINE_DIRTY : 0) |
+                     (prefetched ? LINE_PREFETCHED : 0);
+    if (cache->tag_table_size != 0)
+        tag_insert(cache, set_number, j);
+    make_mru(cache->links + set_number*cache->number_of_lines, set, j);
+    if (cache->policy->fill != NULL)
+        cache->policy->fill(cache, set_number, j);
+    return evicted;
+}
+
+/* Function - cache_lookup
+ * Checking whether the block of an address is cached, and
+ * telling the replacement policy about the hit if so.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache and address.
+ * --------------------------------------------------
+ * Return value:
+ * 1 on a hit, 0 on a miss.
+ * --------------------------------------------------
+ * */
+int cache_lookup(struct cache *cache, unsigned long address){
+    unsigned long set_number = (address >> cache->block_bits) &
+                               ((1UL << cache->set_bits) - 1);
+
+    return touch_line(cache, set_number,
+                      address >> (cache->set_bits + cache->block_bits)) >= 0;
+}
+
+/* Function - cache_insert
+ * Bringing the block of an address into its set.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache, address of a block that isn't cached and
+ * where to store the address of the evicted block.
+ * --------------------------------------------------
+ * Return value:
+ * 1 if a clean valid block was evicted, 2 if a dirty one
+ * was, 0 otherwise.
+ * --------------------------------------------------
+ * */
+int cache_insert(struct cache *cache, unsigned long address,
+                 unsigned long *victim){
+    int index_bits = cache->set_bits + cache->block_bits;
+    unsigned long set_number = (address >> cache->block_bits) &
+                               ((1UL << cache->set_bits) - 1);
+    unsigned long victim_tag;
+    int evicted = fill_line(cache, set_number, address >> index_bits, 0,
+                            0, &victim_tag);
+
+    if (!evicted)
+        return 0;
+    *victim = (victim_tag << index_bits) | (set_number << cache->block_bits);
+    return (evicted & EVICTED_DIRTY) ? 2 : 1;
+}
+
+/* Function - cache_line
+ * Finding the line that holds the block of an address, for
+ * callers that keep their own state in its flags.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache and address.
+ * --------------------------------------------------
+ * Return value:
+ * The line word, or NULL if the block isn't cached.
+ * --------------------------------------------------
+ * */
+unsigned long *cache_line(struct cache *cache, unsigned long address){
+    unsigned long set_number = (address >> cache->block_bits) &
+                               ((1UL << cache->set_bits) - 1);
+    int j = find_line(cache, set_number,
+                      address >> (cache->set_bits + cache->block_bits));
+
+    if (j < 0)
+        return NULL;
+    return cache->lines + set_number*cache->number_of_lines + j;
+}
+
+/* Function - cache_remove
+ * Invalidating the block of an address, if it is cached.
+ * The line moves to the LRU end to be filled next.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache and address.
+ * --------------------------------------------------
+ * Return value:
+ * 1 if the block was cached, 0 otherwise.
+ * --------------------------------------------------
+ * */
+int cache_remove(struct cache *cache, unsigned long address){
+    unsigned long set_number = (address >> cache->block_bits) &
+                               ((1UL << cache->set_bits) - 1);
+    unsigned long tag_number = address >>
+                               (cache->set_bits + cache->block_bits);
+    unsigned long *current_set =
+        cache->lines + set_number*cache->number_of_lines;
+    int j = find_line(cache, set_number, tag_number);
+
+    if (j < 0)
+        return 0;
+    if (cache->tag_table_size != 0)
+        tag_remove(cache, set_number, j);
+    current_set[j] &= ~(LINE_VALID | LINE_PREFETCHED);
+    make_lru(cache->links + set_number*cache->number_of_lines,
+             cache->sets + set_number, j);
+    return 1;
+}
+
+/* Function - cache_access
+ * Defining and implementing a cache access function,
+ * which calculates the number of hits, misses and
+ * evictions based on the current address location
+ * of the cache acccess.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache and current address of trace.
+ * --------------------------------------------------
+ * Return value:
+ * 1 on a hit, 0 on a miss.
+ * --------------------------------------------------
+ * */
+int cache_access(struct cache *cache, unsigned long address){
+    return cache_access_block(cache, address >> cache->block_bits);
+}
+
+/* Function - cache_access_block
+ * cache_access for a block number (address >> b), so that
+ * callers running many caches with the same b can split
+ * the address once.
+ * */
+int cache_access_block(struct cache *cache, unsigned long block){
+    return cache_reference(cache, block, 0, 0, &cache->counts);
+}
+
+/* Function - cache_store
+ * cache_access for a store of 'size' bytes.
+ * */
+int cache_store(struct cache *cache, unsigned long address,
+                unsigned size){
+    return cache_reference(cache, address >> cache->block_bits, 1, size,
+                           &cache->counts);
+}
+
+/* Function - count_eviction
+ * Counting what fill_line evicted, dirty blocks being written
+ * back whole.
+ * */
+static inline void count_eviction(struct cache *cache, int evicted,
+                                  struct cache_counts *counts){
+    if (!evicted)
+        return;
+    counts->eviction_count++;
+    if (evicted & EVICTED_DIRTY) {
+        counts->dirty_eviction_count++;
+        counts->write_bytes += 1UL << cache->block_bits;
+    }
+    if (evicted & EVICTED_UNUSED)
+        counts->prefetch_unused_count++;
+}
+
+/* Function - cache_reference
+ * Simulating a load or store to a block. Loads and stores
+ * to a write-allocate cache fill the block on a miss, and
+ * an evicted dirty block is written back whole. Stores
+ * mark the line dirty in a write-back cache, otherwise the
+ * stored bytes go on to the next level.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache, block number, 1 for a store, number of
+ * bytes stored and the counts to add to.
+ * --------------------------------------------------
+ * Return value:
+ * 1 on a hit, 2 on the first hit of a prefetched block and
+ * 0 on a miss.
+ * --------------------------------------------------
+ * */
+int cache_reference(struct cache *cache, unsigned long block, int write,
+                    unsigned size, struct cache_counts *counts){
+    unsigned long set_number = block & ((1UL << cache->set_bits) - 1);
+    unsigned long tag_number = block >> cache->set_bits;
+    unsigned long victim_tag;
+    int j = touch_line(cache, set_number, tag_number);
+    unsigned long *line;
+    int evicted;
+
+    if (j >= 0) {
+        line = cache->lines + set_number*cache->number_of_lines + j;
+        counts->hit_count++;
+        if (write && cache->write_back)
+            *line |= LINE_DIRTY;
+        else if (write)
+            counts->write_bytes += size;
+        if (*line & LINE_PREFETCHED) {
+            *line &= ~LINE_PREFETCHED;
+            counts->prefetch_hit_count++;
+            return 2;
+        }
+        return 1;
+    }
+    counts->miss_count++;
+    if (write && !cache->write_allocate) {
+        counts->write_bytes += size;
+        return 0;
+    }
+    evicted = fill_line(cache, set_number, tag_number,
+                        write && cache->write_back, 0, &victim_tag);
+    count_eviction(cache, evicted, counts);
+    if (write && !cache->write_back)
+        counts->write_bytes += size;
+    return 0;
+}
+
+/* Function - cache_prefetch
+ * Filling a block that isn't cached as a prefetch. Cached
+ * blocks are left alone, so a prefetch never counts as a use.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Pointer to cache, block number and the counts to add to.
+ * --------------------------------------------------
+ * Return value:
+ * 1 if the block was filled, 0 if it was already cached.
+ * --------------------------------------------------
+ * */
+int cache_prefetch(struct cache *cache, unsigned long block,
+                   struct cache_counts *counts){
+    unsigned long set_number = block & ((1UL << cache->set_bits) - 1);
+    unsigned long tag_number = block >> cache->set_bits;
+    unsigned long victim_tag;
+
+    if (find_line(cache, set_number, tag_number) >= 0)
+        return 0;
+    counts->prefetch_count++;
+    count_eviction(cache,
+                   fill_line(cache, set_number, tag_number, 0, 1,
+                             &victim_tag),
+                   counts);
+    return 1;
+}
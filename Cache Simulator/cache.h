@@ -0,0 +1,192 @@
+/*
+ * cache.h - One set associative cache
+ *
+ * A cache is described by the number of set bits (s), lines per set
+ * (E) and block offset bits (b), like the csim command line, and a
+ * replacement policy (see replacement.h). Any number of caches can
+ * exist side by side, e.g. the levels of a hierarchy.
+ *
+ * Stores follow the write policy of the cache. Write-back caches
+ * mark the line dirty and write the whole block to the next level
+ * when it is evicted, write-through caches pass every store on.
+ * Without write-allocate a store miss leaves the cache alone and
+ * only writes the stored bytes to the next level.
+ *
+ * Prefetched blocks (see prefetch.h) are marked until their first
+ * demand hit, so prefetches that are used and prefetched blocks that
+ * are evicted unused can be counted.
+ *
+ * Addresses and tags are 64 bits wide. To keep large caches small,
+ * a line is a single word holding its tag shifted up by
+ * LINE_FLAG_BITS with the LINE_ flags below it, plus its place in
+ * the recency list, plus a word of policy state only for the
+ * policies that keep some: 16 bytes per line for LRU. A tag whose
+ * top bits get shifted out is one of an address whose top bits all
+ * copy the same bit (s + b < 6 and a canonical x86-64 address), so
+ * no two addresses alias.
+ */
+
+#ifndef CSIM_CACHE_H
+#define CSIM_CACHE_H
+
+#include "replacement.h"
+
+/* Sets with more lines than this get a tag lookup table instead of
+ * having their tags scanned on every access. Scans compare 4 tags
+ * at a time with AVX2, which keeps them ahead of the table for
+ * larger sets (see cache_bench.c). */
+#if defined(__AVX2__)
+#define TAG_SCAN_MAX 128
+#else
+#define TAG_SCAN_MAX 64
+#endif
+
+/* Flags in the low bits of a line word.
+ * LINE_VALID - This bit is set to '0' intially and then '1'
+ *              to simulate cold misses
+ * LINE_DIRTY - Set by a store to a write-back cache, cleared on a
+ *              fill.
+ * LINE_PREFETCHED - Set by a prefetch fill, cleared by the first
+ *                   demand hit.
+ * LINE_COHERENCE - Protocol state, owned by coherence.c.
+ * */
+#define LINE_VALID      1UL
+#define LINE_DIRTY      2UL
+#define LINE_PREFETCHED 4UL
+#define LINE_COHERENCE_SHIFT 3
+#define LINE_COHERENCE  (7UL << LINE_COHERENCE_SHIFT)
+#define LINE_FLAG_BITS  6
+
+/* Line word of a valid, clean line holding a tag. A line holds the
+ * tag if its word without the other flags equals this. */
+#define LINE_WORD(tag) (((tag) << LINE_FLAG_BITS) | LINE_VALID)
+#define LINE_STATUS (LINE_DIRTY | LINE_PREFETCHED | LINE_COHERENCE)
+
+/* Tag of a line word. The shift copies the top bit down, which gives
+ * back the top bits of a tag that was shifted out (see above) and
+ * only sets bits beyond the address otherwise. */
+#define LINE_TAG(word) \
+    ((unsigned long)((long)(word) >> LINE_FLAG_BITS))
+
+/* Definining the structure cache link - a line's place in the
+ * recency list of its set.
+ * prev, next - Line indices of the neighbours (prev is more recently
+ *              used), -1 at the ends of the list.
+ * */
+struct cache_link {
+    int prev;
+    int next;
+};
+
+/* Definining the structure cache set - the recency list of a set.
+ * Invalid lines are kept at the LRU end, so a set with room is
+ * always filled from there.
+ * mru - Index of the most recently used line.
+ * lru - Index of the least recently used line.
+ * random_state - Random numbers of the replacement policy.
+ * */
+struct cache_set {
+    int mru;
+    int lru;
+    unsigned long random_state;
+};
+
+/* Definining the structure cache counts - what the accesses of a
+ * cache added up to.
+ * dirty_eviction_count - Evicted blocks that had to be written back.
+ * write_bytes - Bytes written to the next level, by write-backs and
+ *               by stores that went through.
+ * prefetch_count - Blocks brought in by prefetches.
+ * prefetch_hit_count - Prefetched blocks that got a demand hit.
+ * prefetch_unused_count - Prefetched blocks evicted before any.
+ * */
+struct cache_counts {
+    unsigned long hit_count;
+    unsigned long miss_count;
+    unsigned long eviction_count;
+    unsigned long dirty_eviction_count;
+    unsigned long write_bytes;
+    unsigned long prefetch_count;
+    unsigned long prefetch_hit_count;
+    unsigned long prefetch_unused_count;
+};
+
+/* Definining the structure cache.
+ * set_bits, number_of_lines, block_bits - Geometry (s, E, b).
+ * tag_table_size - Slots per set in tag_table, 0 when the lines
+ *                  of a set are simply scanned.
+ * lines - Line words, the E of set i start at lines + i*E.
+ * links - Recency list of every line, indexed like lines.
+ * state - Per line, owned by the replacement policy. NULL for
+ *         policies without hit or fill hooks.
+ * policy - Replacement policy.
+ * write_back - 1 for write-back (the default), 0 for write-through.
+ * write_allocate - 1 if store misses fill a line (the default).
+ * counts - Totals of cache_access and cache_store.
+ * */
+struct cache {
+    int set_bits;
+    int number_of_lines;
+    int block_bits;
+    int tag_table_size;
+    unsigned long *lines;
+    struct cache_link *links;
+    unsigned *state;
+    struct cache_set *sets;
+    int *tag_table;
+    const struct replacement_policy *policy;
+    int write_back;
+    int write_allocate;
+    struct cache_counts counts;
+};
+
+/* Sets up an empty cache, returns 0 on success and -1 on error. The
+ * policy has to support E (see replacement_supports). */
+int cache_init(struct cache *cache, int set_bits, int number_of_lines,
+               int block_bits, const struct replacement_policy *policy);
+
+/* Releases the memory of a cache */
+void cache_free(struct cache *cache);
+
+/* Looks up a block without counting anything. Returns 1 and records
+ * the hit with the policy if it is cached, 0 otherwise. */
+int cache_lookup(struct cache *cache, unsigned long address);
+
+/* Brings a block that isn't cached in. Returns 1 (2 if it was
+ * dirty) and stores the address of the evicted block in *victim if
+ * a valid block had to make room, 0 otherwise. */
+int cache_insert(struct cache *cache, unsigned long address,
+                 unsigned long *victim);
+
+/* Returns the word of the line holding a block, or NULL if it isn't
+ * cached. The replacement policy isn't told. */
+unsigned long *cache_line(struct cache *cache, unsigned long address);
+
+/* Drops a block, returns 1 if it was cached */
+int cache_remove(struct cache *cache, unsigned long address);
+
+/* A lookup followed by an insert on a miss, counting hits, misses
+ * and evictions. Returns 1 on a hit. */
+int cache_access(struct cache *cache, unsigned long address);
+
+/* cache_access for the block number address >> b */
+int cache_access_block(struct cache *cache, unsigned long block);
+
+/* cache_access for a store of 'size' bytes, following the write
+ * policy. Returns 1 on a hit. */
+int cache_store(struct cache *cache, unsigned long address,
+                unsigned size);
+
+/* Loads (write 0) or stores 'size' bytes to a block number, adding
+ * to 'counts' instead of the cache's own totals, so that threads
+ * sharing a cache by sets can count separately. Returns 1 on a hit,
+ * 2 on the first hit of a prefetched block and 0 on a miss. */
+int cache_reference(struct cache *cache, unsigned long block, int write,
+                    unsigned size, struct cache_counts *counts);
+
+/* Brings a block number in as a prefetch, without counting a hit or
+ * miss. Returns 1 if it was filled, 0 if it was already cached. */
+int cache_prefetch(struct cache *cache, unsigned long block,
+                   struct cache_counts *counts);
+
+#endif /* CSIM_CACHE_H */
@@ -0,0 +1,140 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Lookup benchmark for struct cache. Runs the same
+ * random accesses on caches of 64KB with 1 to 256 lines
+ * per set and prints the accesses per second of each E,
+ * which is mostly the cost of finding a tag in a set.
+ * Sets of up to TAG_SCAN_MAX lines are scanned, with AVX2
+ * or SSE4.1 compares when the compiler targets them, so
+ * building it with and without -mavx2 compares the
+ * vector and scalar scans:
+ *
+ *     make clean; make cache_bench SIMD=-mavx2
+ *
+ * Run as './cache_bench [rounds]'.
+ ********************************************************/
+
+/* clock_gettime isn't part of C99 */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "cache.h"
+
+/* Cache capacity as log2 of bytes, and of bytes per block */
+#define CAPACITY_BITS 16
+#define BLOCK_BITS 6
+
+/* Accesses per round, over a working set of twice the capacity
+ * (four regions of half of it) so that about half of them hit */
+#define ACCESS_COUNT (1UL << 22)
+#define REGION_BITS (CAPACITY_BITS - 1)
+
+static unsigned rounds = 10;
+
+/* Function - seconds
+ * Monotonic time in seconds.
+ * */
+static double seconds(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* Function - make_addresses
+ * Random block aligned addresses in the working set, spread
+ * over a few address space regions so tags differ in their
+ * high bits too.
+ * */
+static unsigned long *make_addresses(void){
+    unsigned long *address = malloc(ACCESS_COUNT * sizeof(unsigned long));
+    unsigned long x = 0x9e3779b97f4a7c15UL;
+    unsigned long i;
+
+    if (address == NULL)
+        return NULL;
+    for (i = 0; i < ACCESS_COUNT; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        address[i] = ((x >> 40) % 4) << 44 |
+                     ((x & ((1UL << REGION_BITS) - 1)) &
+                      ~((1UL << BLOCK_BITS) - 1));
+    }
+    return address;
+}
+
+/* Function - run
+ * Timing 'rounds' passes of cache_access over the addresses
+ * on a fresh LRU cache with E lines per set.
+ * ---------------------------------------------------
+ * Input parameters:
+ * log2 of E, the addresses and where to store the hits.
+ * --------------------------------------------------
+ * Return value:
+ * Accesses per second, or -1 if the cache couldn't be
+ * allocated.
+ * --------------------------------------------------
+ * */
+static double run(int line_bits, const unsigned long *address,
+                  unsigned long *hits){
+    struct cache cache;
+    double start, elapsed;
+    unsigned long i;
+    unsigned r;
+
+    if (cache_init(&cache, CAPACITY_BITS - BLOCK_BITS - line_bits,
+                   1 << line_bits, BLOCK_BITS, replacement_find("lru")) < 0)
+        return -1;
+    *hits = 0;
+    start = seconds();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < ACCESS_COUNT; i++)
+            *hits += cache_access(&cache, address[i]);
+    }
+    elapsed = seconds() - start;
+    cache_free(&cache);
+    return (double)rounds * ACCESS_COUNT / elapsed;
+}
+
+int main(int argc, char *argv[]){
+    unsigned long *address;
+    unsigned long hits;
+    double rate;
+    int line_bits;
+
+    if (argc > 1 && (rounds = atoi(argv[1])) == 0) {
+        printf("Usage: %s [rounds]\n", argv[0]);
+        return 1;
+    }
+    if ((address = make_addresses()) == NULL) {
+        printf("Malloc error !");
+        return 3;
+    }
+
+#if defined(__AVX2__)
+    printf("tag scan: AVX2\n");
+#elif defined(__SSE4_1__)
+    printf("tag scan: SSE4.1\n");
+#else
+    printf("tag scan: scalar\n");
+#endif
+    printf("%4s %6s %14s %8s\n", "E", "sets", "Maccesses/s", "hit%");
+    for (line_bits = 0; line_bits <= 8; line_bits++) {
+        if ((rate = run(line_bits, address, &hits)) < 0) {
+            printf("Malloc error !");
+            return 3;
+        }
+        printf("%4d %6d %14.1f %7.2f%%%s\n", 1 << line_bits,
+               1 << (CAPACITY_BITS - BLOCK_BITS - line_bits), rate / 1e6,
+               100.0 * hits / ((double)rounds * ACCESS_COUNT),
+               (1 << line_bits) > TAG_SCAN_MAX ? "  (tag table)" : "");
+    }
+    free(address);
+    return 0;
+}
@@ -0,0 +1,261 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * 3C miss classification for the cache simulator. A
+ * fully associative LRU cache of the same capacity
+ * shadows the real one, and a hash table of every
+ * block seen tells first accesses apart and collects
+ * the misses of each block. The report ranks lines by
+ * misses and sets by conflict misses, with a bar per
+ * set so hot sets stand out.
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "classify.h"
+
+/* Width of the longest bar of the set histogram */
+#define BAR_WIDTH 40
+
+/* Function - block_home
+ * Home slot of a block in the block table.
+ * */
+static inline unsigned long block_home(struct classifier *classifier,
+                                       unsigned long block){
+    return ((block * 0x9e3779b97f4a7c15UL) >> 32) &
+           (classifier->block_table_size-1);
+}
+
+/* Function - block_slot
+ * Finding the slot of a block, or the empty slot it would go
+ * in.
+ * */
+static struct block_record *block_slot(struct classifier *classifier,
+                                       unsigned long block){
+    unsigned long slot = block_home(classifier, block);
+
+    while (classifier->blocks[slot].miss_count != 0 &&
+           classifier->blocks[slot].block != block)
+        slot = (slot+1) & (classifier->block_table_size-1);
+    return classifier->blocks + slot;
+}
+
+/* Function - grow_blocks
+ * Doubling the block table, which starts out with 4096 slots
+ * and is kept at most half full.
+ * */
+static int grow_blocks(struct classifier *classifier){
+    unsigned long size = classifier->block_table_size ?
+                         2*classifier->block_table_size : 4096;
+    struct block_record *old = classifier->blocks;
+    unsigned long old_size = classifier->block_table_size;
+    unsigned long i;
+
+    classifier->blocks = calloc(size, sizeof(struct block_record));
+    if (classifier->blocks == NULL) {
+        classifier->blocks = old;
+        return -1;
+    }
+    classifier->block_table_size = size;
+    for (i = 0; i < old_size; i++) {
+        if (old[i].miss_count != 0)
+            *block_slot(classifier, old[i].block) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+/* Function - classify_init
+ * Setting up the shadow cache with 2^s * E lines in one set
+ * and empty tables.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Classifier and the cache to classify the misses of.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if the memory couldn't be allocated.
+ * --------------------------------------------------
+ * */
+int classify_init(struct classifier *classifier, const struct cache *cache){
+    memset(classifier, 0, sizeof(struct classifier));
+    classifier->cache = cache;
+    classifier->sets = calloc(1UL << cache->set_bits,
+                              sizeof(struct set_misses));
+    if (classifier->sets == NULL)
+        return -1;
+    if (cache_init(&classifier->shadow, 0,
+                   cache->number_of_lines << cache->set_bits,
+                   cache->block_bits, replacement_find("lru")) < 0 ||
+        grow_blocks(classifier) < 0) {
+        classify_free(classifier);
+        return -1;
+    }
+    return 0;
+}
+
+/* Function - classify_free
+ * Releasing the shadow cache and the tables.
+ * */
+void classify_free(struct classifier *classifier){
+    cache_free(&classifier->shadow);
+    free(classifier->blocks);
+    free(classifier->sets);
+    classifier->blocks = NULL;
+    classifier->sets = NULL;
+}
+
+/* Function - classify_access
+ * Running an access on the shadow cache and, if the real
+ * cache missed, putting the miss down to a block and set.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Classifier, address and whether the real cache hit.
+ * --------------------------------------------------
+ * Return value:
+ * 0, or -1 if the block table couldn't grow.
+ * --------------------------------------------------
+ * */
+int classify_access(struct classifier *classifier, unsigned long address,
+                    int hit){
+    const struct cache *cache = classifier->cache;
+    unsigned long block = address >> cache->block_bits;
+    struct set_misses *set =
+        classifier->sets + (block & ((1UL << cache->set_bits) - 1));
+    struct block_record *record;
+    int shadow_hit = cache_access(&classifier->shadow, address);
+
+    if (hit)
+        return 0;
+    record = block_slot(classifier, block);
+    if (record->miss_count == 0) {
+        // Room for the new block keeps the table at most half full.
+        if (2*(classifier->block_count+1) > classifier->block_table_size) {
+            if (grow_blocks(classifier) < 0)
+                return -1;
+            record = block_slot(classifier, block);
+        }
+        record->block = block;
+        classifier->block_count++;
+        set->compulsory_count++;
+        classifier->total.compulsory_count++;
+    } else if (shadow_hit) {
+        record->conflict_count++;
+        set->conflict_count++;
+        classifier->total.conflict_count++;
+    } else {
+        set->capacity_count++;
+        classifier->total.capacity_count++;
+    }
+    record->miss_count++;
+    return 0;
+}
+
+/* Function - compare_blocks
+ * qsort order of block records, most misses first.
+ * */
+static int compare_blocks(const void *a, const void *b){
+    const struct block_record *x = *(const struct block_record *const *)a;
+    const struct block_record *y = *(const struct block_record *const *)b;
+
+    if (x->miss_count != y->miss_count)
+        return x->miss_count < y->miss_count ? 1 : -1;
+    return (x->block > y->block) - (x->block < y->block);
+}
+
+/* Function - report_lines
+ * Printing the 'top' lines with the most misses, with the
+ * set they map to and their misses by kind.
+ * */
+static void report_lines(struct classifier *classifier, int top, FILE *out){
+    const struct cache *cache = classifier->cache;
+    struct block_record **worst;
+    unsigned long count = 0;
+    unsigned long i;
+
+    worst = malloc((classifier->block_count + 1) * sizeof(*worst));
+    if (worst == NULL)
+        return;
+    for (i = 0; i < classifier->block_table_size; i++) {
+        if (classifier->blocks[i].miss_count != 0)
+            worst[count++] = classifier->blocks + i;
+    }
+    qsort(worst, count, sizeof(*worst), compare_blocks);
+    fprintf(out, "%-18s %8s %12s %12s %12s\n", "line", "set", "misses",
+            "capacity", "conflict");
+    for (i = 0; i < count && i < (unsigned long)top; i++) {
+        struct block_record *record = worst[i];
+        fprintf(out, "0x%016lx %8lu %12u %12u %12u\n",
+                record->block << cache->block_bits,
+                record->block & ((1UL << cache->set_bits) - 1),
+                record->miss_count,
+                // The first miss of a block is its compulsory one.
+                record->miss_count - 1 - record->conflict_count,
+                record->conflict_count);
+    }
+    free(worst);
+}
+
+/* Function - compare_sets
+ * qsort order of sets, most conflict misses first.
+ * */
+static int compare_sets(const void *a, const void *b){
+    const struct set_misses *x = *(const struct set_misses *const *)a;
+    const struct set_misses *y = *(const struct set_misses *const *)b;
+
+    if (x->conflict_count != y->conflict_count)
+        return x->conflict_count < y->conflict_count ? 1 : -1;
+    return (x > y) - (x < y);
+}
+
+/* Function - report_sets
+ * Printing the 'top' sets with the most conflict misses, with
+ * a bar scaled to the worst one and how far above the mean
+ * they are.
+ * */
+static void report_sets(struct classifier *classifier, int top, FILE *out){
+    unsigned long number_of_sets = 1UL << classifier->cache->set_bits;
+    double mean = (double)classifier->total.conflict_count / number_of_sets;
+    struct set_misses **worst;
+    struct set_misses *set;
+    unsigned long i;
+    int width;
+
+    worst = malloc(number_of_sets * sizeof(*worst));
+    if (worst == NULL)
+        return;
+    for (i = 0; i < number_of_sets; i++)
+        worst[i] = classifier->sets + i;
+    qsort(worst, number_of_sets, sizeof(*worst), compare_sets);
+
+    fprintf(out, "conflict misses per set: mean %.1f\n", mean);
+    fprintf(out, "%8s %12s %12s %12s %6s\n", "set", "compulsory",
+            "capacity", "conflict", "x mean");
+    for (i = 0; i < number_of_sets && i < (unsigned long)top; i++) {
+        set = worst[i];
+        width = worst[0]->conflict_count ?
+                (int)(BAR_WIDTH * set->conflict_count /
+                      worst[0]->conflict_count) : 0;
+        fprintf(out, "%8lu %12lu %12lu %12lu %6.1f %.*s\n",
+                (unsigned long)(set - classifier->sets),
+                set->compulsory_count, set->capacity_count,
+                set->conflict_count,
+                mean > 0 ? set->conflict_count / mean : 0.0, width,
+                "########################################");
+    }
+    free(worst);
+}
+
+/* Function - classify_report
+ * Printing the misses by kind, then the worst lines and sets.
+ * */
+void classify_report(struct classifier *classifier, int top, FILE *out){
+    fprintf(out, "compulsory:%lu capacity:%lu conflict:%lu\n",
+            classifier->total.compulsory_count,
+            classifier->total.capacity_count,
+            classifier->total.conflict_count);
+    report_lines(classifier, top, out);
+    report_sets(classifier, top, out);
+}
@@ -0,0 +1,73 @@
+/*
+ * classify.h - Compulsory, capacity and conflict misses (the 3Cs)
+ *
+ * Every access of a cache is replayed on a shadow fully associative
+ * LRU cache with as many blocks, and every block seen so far is kept
+ * in a table. A miss of the real cache is
+ * compulsory - if the block was never accessed before,
+ * capacity   - if the shadow cache missed too, and
+ * conflict   - if the shadow cache hit, so only the mapping of blocks
+ *              to sets made it miss.
+ * Misses are added up per block, to find the lines behind them, and
+ * per set, to find the sets that conflict misses pile up in.
+ */
+
+#ifndef CSIM_CLASSIFY_H
+#define CSIM_CLASSIFY_H
+
+#include <stdio.h>
+#include "cache.h"
+
+/* Definining the structure block record - misses of one block.
+ * miss_count - All misses of the block, 0 for an empty slot of the
+ *              table (the first access always misses).
+ * conflict_count - The conflict misses among them.
+ * */
+struct block_record {
+    unsigned long block;
+    unsigned miss_count;
+    unsigned conflict_count;
+};
+
+/* Definining the structure set misses - misses of one set, by kind */
+struct set_misses {
+    unsigned long compulsory_count;
+    unsigned long capacity_count;
+    unsigned long conflict_count;
+};
+
+/* Definining the structure classifier.
+ * cache - The cache whose misses are classified.
+ * shadow - Fully associative LRU cache of the same capacity.
+ * blocks, block_table_size, block_count - Open addressing table of
+ *                                         every block seen.
+ * sets - Misses per set of the classified cache.
+ * */
+struct classifier {
+    const struct cache *cache;
+    struct cache shadow;
+    struct block_record *blocks;
+    unsigned long block_table_size;
+    unsigned long block_count;
+    struct set_misses *sets;
+    struct set_misses total;
+};
+
+/* Sets up a classifier for the misses of 'cache', returns 0 on
+ * success and -1 on error */
+int classify_init(struct classifier *classifier, const struct cache *cache);
+
+/* Releases the shadow cache and the tables */
+void classify_free(struct classifier *classifier);
+
+/* Records an access that the classified cache has just simulated,
+ * 'hit' being its outcome. Returns 0, or -1 if the block table
+ * couldn't grow. */
+int classify_access(struct classifier *classifier, unsigned long address,
+                    int hit);
+
+/* Prints the totals of each kind, the 'top' lines with the most
+ * misses and the 'top' sets with the most conflict misses */
+void classify_report(struct classifier *classifier, int top, FILE *out);
+
+#endif /* CSIM_CLASSIFY_H */
@@ -0,0 +1,477 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Snooping MESI and MOESI coherence between private
+ * caches. The protocol state of a line lives in its
+ * 'coherence' field, and lines in Modified or Owned
+ * state are also marked dirty, so that cache_insert
+ * reports the write-back when they are evicted.
+ * Blocks that lose a copy to an invalidation get a
+ * sharing record in a hash table, which follows the
+ * words written afterwards to tell false sharing from
+ * true sharing.
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coherence.h"
+
+/* Protocol states of a valid line, invalid lines are simply not
+ * cached */
+#define STATE_SHARED    1
+#define STATE_EXCLUSIVE 2
+#define STATE_OWNED     3
+#define STATE_MODIFIED  4
+
+/* Function - line_state
+ * Protocol state kept in the LINE_COHERENCE bits of a line.
+ * */
+static inline int line_state(unsigned long line){
+    return (int)((line & LINE_COHERENCE) >> LINE_COHERENCE_SHIFT);
+}
+
+/* Function - set_line_state
+ * Changing the protocol state of a line, leaving its dirty bit
+ * to the caller.
+ * */
+static inline void set_line_state(unsigned long *line, int state){
+    *line = (*line & ~LINE_COHERENCE) |
+            ((unsigned long)state << LINE_COHERENCE_SHIFT);
+}
+
+/* Function - line_home
+ * Home slot of a block in the sharing table.
+ * */
+static inline unsigned long line_home(struct coherence *co,
+                                      unsigned long block){
+    return ((block * 0x9e3779b97f4a7c15UL) >> 32) &
+           (co->line_table_size-1);
+}
+
+/* Function - find_record
+ * Looking up the sharing record of a block.
+ * ---------------------------------------------------
+ * Return value:
+ * The record, or NULL if the block has none.
+ * --------------------------------------------------
+ * */
+static struct line_sharing *find_record(struct coherence *co,
+                                        unsigned long block){
+    unsigned long slot;
+
+    if (co->line_count == 0)
+        return NULL;
+    for (slot = line_home(co, block); co->lines[slot].used;
+         slot = (slot+1) & (co->line_table_size-1)) {
+        if (co->lines[slot].block == block)
+            return co->lines + slot;
+    }
+    return NULL;
+}
+
+/* Function - grow_records
+ * Doubling the sharing table, which starts out with 1024 slots
+ * and is kept at most half full.
+ * */
+static int grow_records(struct coherence *co){
+    unsigned long size = co->line_table_size ? 2*co->line_table_size :
+                                               1024;
+    struct line_sharing *old = co->lines;
+    unsigned long old_size = co->line_table_size;
+    unsigned long i;
+    unsigned long slot;
+
+    co->lines = calloc(size, sizeof(struct line_sharing));
+    if (co->lines == NULL) {
+        co->lines = old;
+        return -1;
+    }
+    co->line_table_size = size;
+    for (i = 0; i < old_size; i++) {
+        if (!old[i].used)
+            continue;
+        for (slot = line_home(co, old[i].block); co->lines[slot].used;
+             slot = (slot+1) & (size-1))
+            ;
+        co->lines[slot] = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+/* Function - get_record
+ * Looking up the sharing record of a block, making an empty
+ * one if it has none.
+ * ---------------------------------------------------
+ * Return value:
+ * The record, or NULL if the table couldn't grow.
+ * --------------------------------------------------
+ * */
+static struct line_sharing *get_record(struct coherence *co,
+                                       unsigned long block){
+    struct line_sharing *record = find_record(co, block);
+    unsigned long slot;
+
+    if (record != NULL)
+        return record;
+    if (2*(co->line_count+1) > co->line_table_size && grow_records(co) < 0)
+        return NULL;
+    for (slot = line_home(co, block); co->lines[slot].used;
+         slot = (slot+1) & (co->line_table_size-1))
+        ;
+    record = co->lines + slot;
+    record->block = block;
+    record->used = 1;
+    record->last_writer = -1;
+    co->line_count++;
+    return record;
+}
+
+/* Function - word_mask
+ * Bit mask of the words of its block that an access of 'size'
+ * bytes touches, cut off at the end of the block.
+ * */
+static unsigned long word_mask(struct coherence *co, unsigned long address,
+                               unsigned size){
+    unsigned long offset = address & ((1UL << co->block_bits) - 1);
+    unsigned long end = offset + (size ? size : 1) - 1;
+    int first;
+    int last;
+
+    if (end >= (1UL << co->block_bits))
+        end = (1UL << co->block_bits) - 1;
+    first = offset >> co->word_shift;
+    last = end >> co->word_shift;
+    // Unsigned shifts by 64 - 1 wrap around to all ones.
+    return ((2UL << last) - 1) & ~((1UL << first) - 1);
+}
+
+/* Function - coherence_init
+ * Setting up the private cache of every core.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Coherence, PROTOCOL_ value, number of cores and the
+ * geometry and replacement policy of their caches.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if the memory couldn't be allocated.
+ * --------------------------------------------------
+ * */
+int coherence_init(struct coherence *co, int protocol, int core_count,
+                   int set_bits, int number_of_lines, int block_bits,
+                   const struct replacement_policy *policy){
+    int k;
+
+    memset(co, 0, sizeof(struct coherence));
+    co->protocol = protocol;
+    co->block_bits = block_bits;
+    co->word_shift = block_bits > 6 ? block_bits - 6 : 0;
+    for (k = 0; k < core_count; k++) {
+        if (cache_init(&co->cores[k].cache, set_bits, number_of_lines,
+                       block_bits, policy) < 0) {
+            coherence_free(co);
+            return -1;
+        }
+        co->core_count++;
+    }
+    return 0;
+}
+
+/* Function - coherence_free
+ * Releasing the caches and the sharing table.
+ * */
+void coherence_free(struct coherence *co){
+    int k;
+
+    for (k = 0; k < co->core_count; k++)
+        cache_free(&co->cores[k].cache);
+    free(co->lines);
+    co->lines = NULL;
+    co->core_count = 0;
+}
+
+/* Function - classify_miss
+ * Counting a miss, and telling a coherence miss and whether
+ * it was false sharing from the block's sharing record.
+ * */
+static void classify_miss(struct coherence *co, int c, unsigned long address,
+                          unsigned size){
+    struct core *core = co->cores + c;
+    struct line_sharing *record = find_record(co, address >> co->block_bits);
+
+    core->miss_count++;
+    if (record == NULL || !(record->lost & (1U << c)))
+        return;
+    core->coherence_miss_count++;
+    record->coherence_miss_count++;
+    if (!(record->stale[c] & word_mask(co, address, size))) {
+        core->false_sharing_count++;
+        record->false_sharing_count++;
+    }
+    record->lost &= ~(1U << c);
+    record->stale[c] = 0;
+}
+
+/* Function - fill
+ * Bringing a block into a core's cache in the given state.
+ * Modified and Owned victims are written back.
+ * */
+static void fill(struct coherence *co, int c, unsigned long address,
+                 int state){
+    struct core *core = co->cores + c;
+    unsigned long *line;
+    unsigned long victim;
+    int evicted = cache_insert(&core->cache, address, &victim);
+
+    if (evicted)
+        core->eviction_count++;
+    if (evicted == 2)
+        core->writeback_count++;
+    line = cache_line(&core->cache, address);
+    set_line_state(line, state);
+    if (state == STATE_MODIFIED)
+        *line |= LINE_DIRTY;
+}
+
+/* Function - invalidate_others
+ * Broadcasting a write: every other copy of the block is
+ * invalidated, a dirty one supplying the data first (and
+ * being written back under MESI).
+ * ---------------------------------------------------
+ * Return value:
+ * 1 if a dirty copy supplied the data, 0 if none did and
+ * -1 if a sharing record couldn't be allocated.
+ * --------------------------------------------------
+ * */
+static int invalidate_others(struct coherence *co, int c,
+                             unsigned long address){
+    struct line_sharing *record = NULL;
+    unsigned long *line;
+    int supplied = 0;
+    int k;
+
+    for (k = 0; k < co->core_count; k++) {
+        if (k == c || (line = cache_line(&co->cores[k].cache,
+                                         address)) == NULL)
+            continue;
+        if (line_state(*line) == STATE_MODIFIED ||
+            line_state(*line) == STATE_OWNED) {
+            supplied = 1;
+            if (co->protocol == PROTOCOL_MESI)
+                co->cores[k].writeback_count++;
+        }
+        if (record == NULL &&
+            (record = get_record(co, address >> co->block_bits)) == NULL)
+            return -1;
+        cache_remove(&co->cores[k].cache, address);
+        co->cores[k].invalidation_count++;
+        co->invalidation_count++;
+        record->invalidation_count++;
+        record->lost |= 1U << k;
+        record->sharers |= 1U << k;
+        record->stale[k] = 0;
+    }
+    return supplied;
+}
+
+/* Function - note_write
+ * Recording the words a core wrote for the cores that have
+ * lost the block, and whether the block changed hands.
+ * */
+static void note_write(struct coherence *co, int c, unsigned long address,
+                       unsigned size){
+    struct line_sharing *record = find_record(co, address >> co->block_bits);
+    unsigned long mask;
+    int k;
+
+    if (record == NULL)
+        return;
+    mask = word_mask(co, address, size);
+    for (k = 0; k < co->core_count; k++) {
+        if (record->lost & (1U << k))
+            record->stale[k] |= mask;
+    }
+    if (record->last_writer >= 0 && record->last_writer != c)
+        record->ping_pong_count++;
+    record->last_writer = c;
+    record->sharers |= 1U << c;
+}
+
+/* Function - core_read
+ * A load: a hit needs no bus traffic, a miss asks the other
+ * cores, which downgrade their copies to Shared (a Modified
+ * one to Owned under MOESI).
+ * */
+static void core_read(struct coherence *co, int c, unsigned long address,
+                      unsigned size){
+    struct core *core = co->cores + c;
+    unsigned long *line;
+    int state = STATE_EXCLUSIVE;
+    int supplied = 0;
+    int k;
+
+    if (cache_lookup(&core->cache, address)) {
+        core->hit_count++;
+        return;
+    }
+    classify_miss(co, c, address, size);
+    co->read_count++;
+    for (k = 0; k < co->core_count; k++) {
+        if (k == c || (line = cache_line(&co->cores[k].cache,
+                                         address)) == NULL)
+            continue;
+        state = STATE_SHARED;
+        switch(line_state(*line)) {
+            case STATE_MODIFIED:
+                supplied = 1;
+                if (co->protocol == PROTOCOL_MOESI) {
+                    set_line_state(line, STATE_OWNED);
+                    break;
+                }
+                co->cores[k].writeback_count++;
+                set_line_state(line, STATE_SHARED);
+                *line &= ~LINE_DIRTY;
+                break;
+            case STATE_OWNED:
+                supplied = 1;
+                break;
+            case STATE_EXCLUSIVE:
+                set_line_state(line, STATE_SHARED);
+                break;
+        }
+    }
+    co->transfer_count += supplied;
+    fill(co, c, address, state);
+}
+
+/* Function - core_write
+ * A store: Modified and Exclusive hits need no bus traffic,
+ * Shared and Owned ones upgrade, and misses read the block
+ * exclusively. Either way all other copies are invalidated.
+ * ---------------------------------------------------
+ * Return value:
+ * 0, or -1 if a sharing record couldn't be allocated.
+ * --------------------------------------------------
+ * */
+static int core_write(struct coherence *co, int c, unsigned long address,
+                      unsigned size){
+    struct core *core = co->cores + c;
+    unsigned long *line;
+    int supplied;
+
+    if (cache_lookup(&core->cache, address)) {
+        core->hit_count++;
+        line = cache_line(&core->cache, address);
+        if (line_state(*line) == STATE_SHARED ||
+            line_state(*line) == STATE_OWNED) {
+            co->upgrade_count++;
+            if (invalidate_others(co, c, address) < 0)
+                return -1;
+        }
+        set_line_state(line, STATE_MODIFIED);
+        *line |= LINE_DIRTY;
+    } else {
+        classify_miss(co, c, address, size);
+        co->read_exclusive_count++;
+        if ((supplied = invalidate_others(co, c, address)) < 0)
+            return -1;
+        co->transfer_count += supplied;
+        fill(co, c, address, STATE_MODIFIED);
+    }
+    note_write(co, c, address, size);
+    return 0;
+}
+
+/* Function - coherence_access
+ * Simulating one data access of a core, 'M' being a load
+ * followed by a store. Instruction fetches are ignored.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Coherence, core number, trace operation, address and size.
+ * --------------------------------------------------
+ * Return value:
+ * 0, or -1 if a sharing record couldn't be allocated.
+ * --------------------------------------------------
+ * */
+int coherence_access(struct coherence *co, int core, char op,
+                     unsigned long address, unsigned size){
+    switch(op) {
+        case 'L':
+            core_read(co, core, address, size);
+            return 0;
+        case 'S':
+            return core_write(co, core, address, size);
+        case 'M':
+            core_read(co, core, address, size);
+            return core_write(co, core, address, size);
+    }
+    return 0;
+}
+
+/* Function - compare_sharing
+ * qsort order of sharing records, most false sharing misses
+ * first, then most coherence misses.
+ * */
+static int compare_sharing(const void *a, const void *b){
+    const struct line_sharing *x = *(const struct line_sharing *const *)a;
+    const struct line_sharing *y = *(const struct line_sharing *const *)b;
+
+    if (x->false_sharing_count != y->false_sharing_count)
+        return x->false_sharing_count < y->false_sharing_count ? 1 : -1;
+    if (x->coherence_miss_count != y->coherence_miss_count)
+        return x->coherence_miss_count < y->coherence_miss_count ? 1 : -1;
+    return (x->block > y->block) - (x->block < y->block);
+}
+
+/* Function - coherence_report
+ * Printing a row of counts per core, the bus traffic and the
+ * 'top' lines with the most false sharing misses.
+ * */
+void coherence_report(struct coherence *co, int top, FILE *out){
+    struct line_sharing **worst;
+    unsigned long count = 0;
+    unsigned long i;
+    int k;
+
+    fprintf(out, "%-5s %12s %12s %12s %12s %12s %12s %12s\n", "core",
+            "hits", "misses", "coherence", "false-share", "evictions",
+            "invalidated", "writebacks");
+    for (k = 0; k < co->core_count; k++) {
+        struct core *core = co->cores + k;
+        fprintf(out, "%-5d %12lu %12lu %12lu %12lu %12lu %12lu %12lu\n",
+                k, core->hit_count, core->miss_count,
+                core->coherence_miss_count, core->false_sharing_count,
+                core->eviction_count, core->invalidation_count,
+                core->writeback_count);
+    }
+    fprintf(out, "%s bus: reads:%lu read-exclusive:%lu upgrades:%lu "
+            "transfers:%lu invalidations:%lu\n",
+            co->protocol == PROTOCOL_MESI ? "MESI" : "MOESI",
+            co->read_count, co->read_exclusive_count, co->upgrade_count,
+            co->transfer_count, co->invalidation_count);
+
+    worst = malloc((co->line_count + 1) * sizeof(*worst));
+    if (worst == NULL)
+        return;
+    for (i = 0; i < co->line_table_size; i++) {
+        if (co->lines[i].used && co->lines[i].coherence_miss_count > 0)
+            worst[count++] = co->lines + i;
+    }
+    qsort(worst, count, sizeof(*worst), compare_sharing);
+    if (count > 0)
+        fprintf(out, "%-18s %12s %12s %12s %12s %8s\n", "line",
+                "false-share", "coherence", "invalidated", "ping-pong",
+                "sharers");
+    for (i = 0; i < count && i < (unsigned long)top; i++) {
+        fprintf(out, "0x%016lx %12lu %12lu %12lu %12lu %8x\n",
+                worst[i]->block << co->block_bits,
+                worst[i]->false_sharing_count,
+                worst[i]->coherence_miss_count,
+                worst[i]->invalidation_count, worst[i]->ping_pong_count,
+                worst[i]->sharers);
+    }
+    free(worst);
+}
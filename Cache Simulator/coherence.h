@@ -0,0 +1,110 @@
+/*
+ * coherence.h - Private caches kept coherent by MESI or MOESI
+ *
+ * Every core has a private cache of the same geometry, and the cores
+ * snoop each other on a shared bus. A read miss takes the block
+ * Exclusive if no other core has it and Shared otherwise. A write
+ * takes it Modified and invalidates every other copy, through an
+ * upgrade if the block was already cached. A Modified block that is
+ * read by another core is written back and becomes Shared under MESI.
+ * Under MOESI it becomes Owned and keeps supplying the data instead.
+ *
+ * A miss on a block that the core lost to an invalidation is a
+ * coherence miss. Blocks are split into up to 64 words, and the
+ * words written by other cores after the invalidation are recorded.
+ * If the missing access touches none of them, the miss only
+ * happened because the words share a block: a false sharing miss.
+ */
+
+#ifndef CSIM_COHERENCE_H
+#define CSIM_COHERENCE_H
+
+#include <stdio.h>
+#include "cache.h"
+
+#define COHERENCE_MAX_CORES 16
+
+#define PROTOCOL_MESI  0
+#define PROTOCOL_MOESI 1
+
+/* Definining the structure core - a private cache and its counts.
+ * coherence_miss_count - Misses on blocks lost to an invalidation.
+ * false_sharing_count - Coherence misses on words nobody wrote.
+ * invalidation_count - Copies invalidated by other cores' writes.
+ * writeback_count - Dirty blocks written back to memory.
+ * */
+struct core {
+    struct cache cache;
+    unsigned long hit_count;
+    unsigned long miss_count;
+    unsigned long coherence_miss_count;
+    unsigned long false_sharing_count;
+    unsigned long eviction_count;
+    unsigned long invalidation_count;
+    unsigned long writeback_count;
+};
+
+/* Definining the structure line sharing - coherence history of a
+ * block that has been invalidated at least once.
+ * lost - Cores whose copy was invalidated and not missed on since.
+ * stale - Per core, the words written by others since it lost the
+ *         block.
+ * sharers - Cores that have accessed the block since then.
+ * last_writer - Core that wrote the block last.
+ * ping_pong_count - Writes by a different core than the last one.
+ * */
+struct line_sharing {
+    unsigned long block;
+    int used;
+    unsigned lost;
+    unsigned sharers;
+    int last_writer;
+    unsigned long stale[COHERENCE_MAX_CORES];
+    unsigned long invalidation_count;
+    unsigned long coherence_miss_count;
+    unsigned long false_sharing_count;
+    unsigned long ping_pong_count;
+};
+
+/* Definining the structure coherence.
+ * read_count, read_exclusive_count, upgrade_count - Bus requests.
+ * transfer_count - Misses served by another core's dirty copy.
+ * lines, line_table_size, line_count - Open addressing table of
+ *                                      line_sharing records.
+ * block_bits, word_shift - log2 of the bytes per block and per word.
+ * */
+struct coherence {
+    int protocol;
+    int core_count;
+    struct core cores[COHERENCE_MAX_CORES];
+    unsigned long read_count;
+    unsigned long read_exclusive_count;
+    unsigned long upgrade_count;
+    unsigned long transfer_count;
+    unsigned long invalidation_count;
+    struct line_sharing *lines;
+    unsigned long line_table_size;
+    unsigned long line_count;
+    int block_bits;
+    int word_shift;
+};
+
+/* Sets up 'core_count' empty caches, returns 0 on success and -1 on
+ * error */
+int coherence_init(struct coherence *co, int protocol, int core_count,
+                   int set_bits, int number_of_lines, int block_bits,
+                   const struct replacement_policy *policy);
+
+/* Releases the caches and the sharing records */
+void coherence_free(struct coherence *co);
+
+/* Simulates one access of a core, 'op' being a trace operation.
+ * Returns 0, or -1 if a sharing record couldn't be allocated. */
+int coherence_access(struct coherence *co, int core, char op,
+                     unsigned long address, unsigned size);
+
+/* Prints the per-core counts, the bus traffic and the 'top' lines
+ * with the most false sharing misses */
+void coherence_report(struct coherence *co, int top, FILE *out);
+
+#endif /* CSIM_COHERENCE_H */
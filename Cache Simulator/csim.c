@@ -9,146 +9,532 @@
  * bits used to represent the block offset (b), the simulator
  * gives the number of hits, misses and evictions for a 
  * particular trace case.
+ * With -c, a whole hierarchy of caches described in a
+ * config file is simulated instead (see hierarchy.h),
+ * and per-level counts and the AMAT are reported, with
+ * an estimate of the memory stall cycles if the config
+ * gives the number of line fill buffers.
+ * The replacement policy is chosen with -r, and -r all
+ * compares every policy in one pass over the trace.
+ * With -R, the miss ratio curves of all cache sizes are
+ * computed in one pass and written as CSV (see mrc.h).
+ * -S and -M sample the blocks for traces too big for
+ * that, -k sampling runs give error bars.
+ * -j splits the sets of a single level cache between
+ * threads, with the same counts as a serial run.
+ * With -w, all configurations of a sweep file (see 
+ * sweep.h) are simulated on one pass over the trace.
+ * -W picks the write policy of a single level cache,
+ * whose dirty evictions and bytes written to the next
+ * level are reported after the summary.
+ * -p puts a prefetcher (see prefetch.h) in front of a
+ * single level cache and reports how its prefetches
+ * did. Prefetchers see all sets, so -j is ignored then.
+ * With -m, the comma separated traces of -t are the
+ * threads of one program. They run on cores with
+ * private caches kept coherent by MESI or MOESI (see
+ * coherence.h), and the lines with the most false
+ * sharing are reported.
+ * -C classifies the misses of a single level cache as
+ * compulsory, capacity or conflict (see classify.h) and
+ * reports the -n lines and sets with the most misses,
+ * which also needs a serial run.
+ * -T translates every data access through the TLBs of
+ * a config file (see tlb.h) first, and can run the page
+ * walks through the cache.
+ * -x splits loads and stores that run past the end of
+ * their block into one access per block touched, and
+ * reports how many were split. That also needs a serial
+ * run, and is off by default as the reference simulator
+ * of the assignment only looks at the first block.
+ * Single level caches are simulated through the library
+ * of libcsim.h, which can also be used on its own.
+ * -Z writes the trace in the compressed format of 
+ * trace.h instead of simulating it. Every mode reads
+ * compressed traces as well as text ones.
  ********************************************************/
 
 #include <stdio.h>
 #include <getopt.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include "cachelab.h"
+#include "trace.h"
+#include "cache.h"
+#include "hierarchy.h"
+#include "mrc.h"
+#include "parallel.h"
+#include "sweep.h"
+#include "coherence.h"
+#include "libcsim.h"
 
 /* Defining and initializing global variables
- * set_bits: Number of bits for sets. 
- * block_bits: Number of bits for block offset.
- * number_of_lines: Number if cache lines in each set.
- * number_of_sets: Total number of cache blocks (S*E).
- * LRU_count: Counter used to find the LRU block in a set.
+ * config: Options of the single level cache. Its s, E and b
+ *         are also those of the coherent caches, and -R uses
+ *         s and b.
 */
-int hit_count = 0;   
-int miss_count = 0;
-int eviction_count = 0;
-
-int set_bits = 0;
-int block_bits = 0; 
-
-int number_of_lines = 0; 
-int number_of_sets = 0; 
-int LRU_count;
-
-/* Definining the structure cache block - the individual cell 
- * inside the cache aray. 
- * valid - This bit is set to '0' intially and then '1'
- *             to simulate cold misses
- * tag    - Tag bit of the current line.
- * block_LRU_count - Used to indicate last valid access.
- *                      The lowest block_LRU_count in each line is
- *                      evicted in case of a miss.
+struct csim_config config;
+
+/* One simulator per replacement policy being compared */
+#define MAX_POLICIES PARALLEL_MAX_CACHES
+struct csim sims[MAX_POLICIES];
+int sim_count = 0;
+
+/* Function - usage
+ * Printing the correct command line format and exiting.
+ * */
+static void usage(void){
+    int k;
+
+    printf("Invalid input format. Correct format is: \n");
+    printf("./csim -s <s> -E <E> -b <b> [-r <policy>|all] [-j <threads>] "
+           "[-W wb|wt,wa|nwa]\n       [-p none|next|stride|stream"
+           "[,<degree>[,<latency>]]] [-C [-n <lines>]] [-T <tlb config>]\n"
+           "       [-x] -t <tracefile>\n");
+    printf("./csim -c <hierarchy config> -t <tracefile>\n");
+    printf("./csim -Z <compressed trace> -t <tracefile>\n");
+    printf("./csim -s <s> -E <E> -b <b> -m mesi|moesi [-r <policy>] "
+           "[-n <lines>]\n       -t <tracefile>,<tracefile>...\n");
+    printf("./csim -w <sweep file> [-j <threads>] -t <tracefile>\n");
+    printf("./csim -R [-s <max s>] -b <b> [-S <rate>] [-M <max blocks>] "
+           "[-k <runs>] -t <tracefile>\n");
+    printf("Replacement policies:");
+    for (k = 0; replacement_policies[k] != NULL; k++)
+        printf(" %s", replacement_policies[k]->name);
+    printf("\n");
+    exit(1);
+}
+
+/* Function - parse_write_policy
+ * Reading the -W argument, a comma separated list of wb
+ * (write-back), wt (write-through), wa (write-allocate) and
+ * nwa (no-write-allocate).
+ * ---------------------------------------------------
+ * Return value:
+ * 0 on success, -1 for an unknown word.
+ * --------------------------------------------------
+ * */
+static int parse_write_policy(char *list){
+    char *word;
+
+    for (word = strtok(list, ","); word != NULL; word = strtok(NULL, ",")) {
+        if (strcmp(word, "wb") == 0)
+            config.write_back = 1;
+        else if (strcmp(word, "wt") == 0)
+            config.write_back = 0;
+        else if (strcmp(word, "wa") == 0)
+            config.write_allocate = 1;
+        else if (strcmp(word, "nwa") == 0)
+            config.write_allocate = 0;
+        else
+            return -1;
+    }
+    return 0;
+}
+
+/* Function - parse_prefetch
+ * Reading the -p argument, a prefetcher name optionally
+ * followed by the degree and the latency in accesses.
+ * ---------------------------------------------------
+ * Return value:
+ * 0 on success, -1 for an unknown prefetcher or a bad number.
+ * --------------------------------------------------
+ * */
+static int parse_prefetch(char *spec){
+    char *word = strtok(spec, ",");
+
+    if (word == NULL || (config.prefetch_kind = prefetch_find(word)) < 0)
+        return -1;
+    if ((word = strtok(NULL, ",")) != NULL)
+        config.prefetch_degree = atoi(word);
+    if (word != NULL && (word = strtok(NULL, ",")) != NULL)
+        config.prefetch_latency = atoi(word);
+    if (config.prefetch_degree < 1 || config.prefetch_latency < 0 ||
+        strtok(NULL, ",") != NULL)
+        return -1;
+    return 0;
+}
+
+/* Function - report_prefetches
+ * Printing how the prefetches of every cache did: used in
+ * time, used before they arrived, or evicted unused.
+ * */
+static void report_prefetches(void){
+    struct csim_stats stats;
+    int k;
+
+    if (sim_count == 1) {
+        csim_get_stats(&sims[0], &stats);
+        printf("prefetches:%lu useful:%lu late:%lu useless:%lu\n",
+               stats.counts.prefetch_count,
+               stats.counts.prefetch_hit_count - stats.prefetch_late_count,
+               stats.prefetch_late_count, stats.counts.prefetch_unused_count);
+        return;
+    }
+    printf("%-8s %12s %12s %12s %12s\n", "policy", "prefetches",
+           "useful", "late", "useless");
+    for (k = 0; k < sim_count; k++) {
+        csim_get_stats(&sims[k], &stats);
+        printf("%-8s %12lu %12lu %12lu %12lu\n",
+               sims[k].cache.policy->name, stats.counts.prefetch_count,
+               stats.counts.prefetch_hit_count - stats.prefetch_late_count,
+               stats.prefetch_late_count, stats.counts.prefetch_unused_count);
+    }
+}
+
+/* Function - report_policies
+ * Printing the counts of every policy side by side, when
+ * more than one was simulated.
+ * */
+static void report_policies(void){
+    struct csim_stats stats;
+    struct cache_counts *counts = &stats.counts;
+    unsigned long accesses;
+    int k;
+
+    printf("%-8s %12s %12s %12s %8s %12s %14s\n", "policy", "hits",
+           "misses", "evictions", "miss%", "dirty-evict", "bytes-written");
+    for (k = 0; k < sim_count; k++) {
+        csim_get_stats(&sims[k], &stats);
+        accesses = counts->hit_count + counts->miss_count;
+        printf("%-8s %12lu %12lu %12lu %7.2f%% %12lu %14lu\n",
+               sims[k].cache.policy->name, counts->hit_count,
+               counts->miss_count, counts->eviction_count,
+               accesses ? 100.0 * counts->miss_count / accesses : 0.0,
+               counts->dirty_eviction_count, counts->write_bytes);
+    }
+}
+
+/* Function - run_hierarchy
+ * Hierarchy mode, the levels come from the config file and
+ * instruction fetches go to the L1 I-cache.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Open trace and path of the config file.
+ * --------------------------------------------------
+ * Return value:
+ * Exit status of csim.
+ * --------------------------------------------------
  * */
-struct cache_block {
-    int valid;
-    int tag;
-    int block_LRU_count;
+static int run_hierarchy(struct trace_reader *trace, char *config_file_name){
+    struct trace_access batch[TRACE_BATCH];
+    struct hierarchy hierarchy;
+    int count;
+    int k;
+
+    if (hierarchy_load(&hierarchy, config_file_name) < 0)
+        exit(4);
+    while ((count = trace_next_batch(trace, batch, TRACE_BATCH)) > 0) {
+        for (k = 0; k < count; k++)
+            hierarchy_access(&hierarchy, batch[k].op, batch[k].address);
+    }
+    trace_close(trace);
+    hierarchy_report(&hierarchy, stdout);
+    hierarchy_free(&hierarchy);
+    return 0;
+}
+
+/* Definining the structure thread trace - the trace of one core
+ * and the rest of its current batch. */
+struct thread_trace {
+    struct trace_reader reader;
+    struct trace_access batch[TRACE_BATCH];
+    int count;
+    int next;
 };
 
-/* Function - cache_access
- * Defining and implementing a cache access function, 
- * which calculates the number of hits, misses and 
- * evictions based on the current address location 
- * of the cache acccess 
+/* Function - run_coherence
+ * Coherence mode, one trace per core. The cores take turns,
+ * one data access each, until all traces have ended.
  * ---------------------------------------------------
  * Input parameters: 
- * Pointer to cache and current address of trace.
+ * Comma separated trace paths, PROTOCOL_ value, policy
+ * of the private caches and the number of lines to report.
  * --------------------------------------------------
  * Return value:
- * Modified pointer to cache after modifications.
+ * Exit status of csim.
  * --------------------------------------------------
  * */
-struct cache_block* cache_access(struct cache_block* cache, int address){
-    int block_LRU_count_smallest = 0;
-    int evict_block_suspect_index = 0;
-    int found_block = 0;    
-    int j = 0;
-    int set_offset = 0;
-    
-    // Extracting the set number and tag_number from address.
-    int set_address_mask = (~(-1 << (set_bits+block_bits)));
-    int set_number = (address & set_address_mask) >> block_bits; 
-    int tag_number = (address >> (set_bits+block_bits)) & set_address_mask;
-
-    // Finding the offset value to traverse the cache array.    
-    set_offset = number_of_lines*set_number;
-    
-    // Pointers to traverse the cache array.
-    struct cache_block *current_block;
-    struct cache_block *current_set;
-    struct cache_block *evict_block_suspect;
-
-    // Current row in cache.
-    current_set = cache + set_offset;     
-
-    // Update LRU_count to indicate cache request.
-    // The lowest LRU_count value in each set will be 
-    // evicted in case of a miss.
-    LRU_count++; 
-
-    // Search for corresponding tag across all lines in the current set.
-    for (j = 0; j < number_of_lines; j++) {
-        current_block = current_set + j;
-        // If the tag is found, then we've found the right block
-        if ((current_block->tag) == tag_number) {   
-            if ((current_block->valid) == 0) {
-                // In case of cold miss, setting valid bit to '1'.
-                // Also incrementing miss_count by 1.
-                (current_block->valid) = 1;
-                (current_block->block_LRU_count) = LRU_count;
-                miss_count++;
-            } else { 
-                // In case of hit, incrementing hit count.
-                (current_block->block_LRU_count) = LRU_count;
-                hit_count++;
-            }
-            found_block = 1;
-            break;
-        } else {
-            found_block = 0;
+static int run_coherence(char *trace_file_names, int protocol,
+                         const struct replacement_policy *policy, int top){
+    struct thread_trace *threads;
+    struct coherence coherence;
+    struct trace_access *access;
+    char *name;
+    int core_count = 0;
+    int running;
+    int k;
+
+    threads = calloc(COHERENCE_MAX_CORES, sizeof(struct thread_trace));
+    if (threads == NULL){
+        printf("Malloc error !");
+        exit(3);
+    }
+    for (name = strtok(trace_file_names, ","); name != NULL;
+         name = strtok(NULL, ",")) {
+        if (core_count == COHERENCE_MAX_CORES)
+            usage();
+        if (trace_open(&threads[core_count].reader, name) < 0){
+            printf("No valid tracefile found \n");
+            exit(2);
         }
-    }    
-
-    // If no corresponding tag is found, then evict the LRU block out 
-    // of the current set. This should also take care of the cold misses
-    // missed in the code above.
-    if (found_block == 0) {
-        miss_count++;
- 
-        // Finding the LRU block's index
-        block_LRU_count_smallest = (current_set->block_LRU_count);
-        for (j = 0; j< number_of_lines; j++){
-            current_block = current_set + j;
-            if (current_block->block_LRU_count < block_LRU_count_smallest){
-                // Update smallest block_LRU_count.
-                block_LRU_count_smallest = (current_block->block_LRU_count); 
-                // Update index of current evict block suspect.
-                evict_block_suspect_index = j;                    
-            } 
+        core_count++;
+    }
+    if (coherence_init(&coherence, protocol, core_count, config.set_bits,
+                       config.number_of_lines, config.block_bits,
+                       policy) < 0){
+        printf("Malloc error !");
+        exit(3);
+    }
+
+    for (running = core_count; running > 0; ) {
+        running = 0;
+        for (k = 0; k < core_count; k++) {
+            struct thread_trace *thread = threads + k;
+            // Skipping instruction fetches, refilling the batch.
+            do {
+                if (thread->next == thread->count) {
+                    thread->count = trace_next_batch(&thread->reader,
+                                                     thread->batch,
+                                                     TRACE_BATCH);
+                    thread->next = 0;
+                }
+                access = thread->batch + thread->next++;
+            } while (thread->count > 0 && access->op == 'I');
+            if (thread->count == 0) {
+                thread->next = 0;
+                continue;
+            }
+            running++;
+            if (coherence_access(&coherence, k, access->op, access->address,
+                                 access->size) < 0){
+                printf("Malloc error !");
+                exit(3);
+            }
         }
+    }
+
+    for (k = 0; k < core_count; k++)
+        trace_close(&threads[k].reader);
+    free(threads);
+    coherence_report(&coherence, top, stdout);
+    coherence_free(&coherence);
+    return 0;
+}
+
+/* Function - run_sweep
+ * Sweep mode, every configuration of the sweep file is 
+ * simulated on one pass over the trace and gets a CSV row.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Open trace, path of the sweep file and number of threads.
+ * --------------------------------------------------
+ * Return value:
+ * Exit status of csim.
+ * --------------------------------------------------
+ * */
+static int run_sweep(struct trace_reader *trace, char *sweep_file_name,
+                     int thread_count){
+    struct sweep sweep;
+
+    if (sweep_load(&sweep, sweep_file_name) < 0)
+        exit(4);
+    if (sweep_run(&sweep, trace, thread_count) < 0){
+        printf("Can't start %d threads\n", thread_count);
+        exit(3);
+    }
+    trace_close(trace);
+    sweep_report(&sweep, stdout);
+    sweep_free(&sweep);
+    return 0;
+}
+
+/* Function - run_mrc
+ * Miss ratio curve mode. Computes the LRU stack distance of
+ * every data access for 1 up to 2^s sets of 2^b byte blocks
+ * and writes the miss ratio of every associativity as CSV.
+ * When sampling, 'run_count' samples with different seeds 
+ * are taken in the same pass and their spread is reported
+ * as error bars.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Open trace, sampling rate, sample limit and number of 
+ * sampling runs.
+ * --------------------------------------------------
+ * Return value:
+ * Exit status of csim.
+ * --------------------------------------------------
+ * */
+static int run_mrc(struct trace_reader *trace, double rate, 
+                   unsigned long sample_max, int run_count){
+    struct trace_access batch[TRACE_BATCH];
+    struct mrc *runs;
+    int sampled = (rate < 1 || sample_max != 0);
+    int count;
+    int k;
+    int r;
+    int status = 0;
 
-        // Evicting LRU block
-        evict_block_suspect = current_set + evict_block_suspect_index;
-        evict_block_suspect->tag = tag_number;
-        evict_block_suspect->block_LRU_count = LRU_count;
-
-        if (evict_block_suspect->valid == 1) {
-            // If valid block, then increment eviction count.
-            // Evict block suspect confirmed.
-            eviction_count++;
-        } else {
-            // Instead, if cold miss block encountered, set valid bit.
-            evict_block_suspect->valid = 1;
+    if (!sampled)
+        run_count = 1;
+    runs = malloc(run_count * sizeof(struct mrc));
+    if (runs == NULL){
+        printf("Malloc error !");
+        exit(3);
+    }
+    for (r = 0; r < run_count; r++) {
+        if (mrc_init(&runs[r], config.set_bits, config.block_bits, rate,
+                     sample_max, r) < 0){
+            printf("Malloc error !");
+            exit(3);
         }
     }
-    return cache;    
+    while ((count = trace_next_batch(trace, batch, TRACE_BATCH)) > 0) {
+        for (k = 0; k < count; k++) {
+            for (r = 0; r < run_count; r++) {
+                switch(batch[k].op) {
+                    case 'M':
+                        // A load followed by a store.
+                        status |= mrc_access(&runs[r], batch[k].address);
+                        status |= mrc_access(&runs[r], batch[k].address);
+                        break;
+                    case 'L':
+                    case 'S':
+                        status |= mrc_access(&runs[r], batch[k].address);
+                        break;
+                }
+            }
+        }
+        if (status < 0){
+            printf("Malloc error !");
+            exit(3);
+        }
+    }
+    trace_close(trace);
+    // With no blocks sampled, the curves would say that every access
+    // hits.
+    for (r = 0; r < run_count; r++) {
+        if (mrc_sample_empty(&runs[r])) {
+            fprintf(stderr, "No blocks sampled at rate %g, try a higher "
+                    "-S\n", rate);
+            exit(1);
+        }
+    }
+    if (sampled)
+        mrc_write_sampled_csv(runs, run_count, stdout);
+    else
+        mrc_write_csv(&runs[0], stdout);
+    for (r = 0; r < run_count; r++)
+        mrc_free(&runs[r]);
+    free(runs);
+    return 0;
 }
 
+/* Function - run_caches
+ * Single level mode, one simulator (see libcsim.h) per
+ * replacement policy, all fed the same trace.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Open trace, -r argument, number of threads, number of
+ * lines to report and whether -W was given.
+ * --------------------------------------------------
+ * Return value:
+ * Exit status of csim.
+ * --------------------------------------------------
+ * */
+static int run_caches(struct trace_reader *trace, char *policy_name,
+                      int thread_count, int top, int write_report){
+    struct trace_access batch[TRACE_BATCH];
+    struct cache *caches[MAX_POLICIES];
+    struct csim_stats stats;
+    int count;
+    int k;
+
+    // One simulator for each policy when they are all compared.
+    for (k = 0; replacement_policies[k] != NULL; k++) {
+        config.policy = replacement_policies[k];
+        if (strcmp(policy_name, "all") == 0) {
+            // Skipping policies that can't handle this E.
+            if (!replacement_supports(config.policy, config.number_of_lines))
+                continue;
+        } else if (strcmp(policy_name, config.policy->name) != 0) {
+            continue;
+        } else if (!replacement_supports(config.policy,
+                                         config.number_of_lines)) {
+            printf("%s needs E to be a power of 2\n", config.policy->name);
+            exit(1);
+        }
+        switch(csim_init(&sims[sim_count], &config)) {
+            case 0:
+                break;
+            case CSIM_NO_MEMORY:
+                // Exiting in case no free space available for malloc
+                // or any other error.
+                printf("Malloc error !");
+                exit(3);
+            case CSIM_BAD_TLB:
+                exit(4);
+            default:
+                usage();
+        }
+        caches[sim_count] = &sims[sim_count].cache;
+        sim_count++;
+    }
+    // The classifier follows the first cache only.
+    if (sim_count == 0 || (config.classify && sim_count > 1))
+        usage();
+
+    // With several threads, the sets are split between them, unless
+    // a prefetcher, the classifier or the TLBs have to see all of them,
+    // or accesses are split between blocks.
+    if (thread_count > 1 && config.prefetch_kind == PREFETCH_NONE &&
+        !config.classify && config.tlb_config == NULL &&
+        !config.split_blocks &&
+        parallel_simulate(trace, caches, sim_count, thread_count) < 0){
+        printf("Can't start %d threads\n", thread_count);
+        exit(3);
+    }
+
+    // Scanning the tracefile a batch of decoded lines at a time
+    // (nothing is left after a parallel run).
+    while ((count = trace_next_batch(trace, batch, TRACE_BATCH)) > 0) {
+        for (k = 0; k < sim_count; k++) {
+            if (csim_access_batch(&sims[k], batch, count) < 0){
+                printf("Malloc error !");
+                exit(3);
+            }
+        }
+    }
+    trace_close(trace);
+
+    if (strcmp(policy_name, "all") == 0)
+        report_policies();
+    else {
+        csim_get_stats(&sims[0], &stats);
+        printSummary(stats.counts.hit_count, stats.counts.miss_count,
+                     stats.counts.eviction_count);
+        // Only with -W, so the default output stays that of the
+        // assignment.
+        if (write_report)
+            printf("dirty_evictions:%lu bytes_written:%lu\n",
+                   stats.counts.dirty_eviction_count,
+                   stats.counts.write_bytes);
+    }
+    if (config.split_blocks) {
+        csim_get_stats(&sims[0], &stats);
+        printf("split_accesses:%lu\n", stats.split_count);
+    }
+    if (config.prefetch_kind != PREFETCH_NONE)
+        report_prefetches();
+    if (config.classify)
+        classify_report(&sims[0].classifier, top, stdout);
+    if (config.tlb_config != NULL)
+        tlb_report(&sims[0].tlb, stdout);
+    for (k = 0; k < sim_count; k++)
+        csim_free(&sims[k]);
+    return 0;
+}
 
 /* Main function
  * ---------------------------------------------------
@@ -161,96 +547,141 @@ struct cache_block* cache_access(struct cache_block* cache, int address){
 int main(int argc, char *argv[]) {
     // Defining necessary variables.
     int opt;
-    int i = 0;
-    int j = 0;
 
-    unsigned address = 0;
-    unsigned numbytes = 0;
+    char *trace_file_name = NULL;
+    char *config_file_name = NULL;
+    char *sweep_file_name = NULL;
+    char *compressed_file_name = NULL;
+    char *policy_name = "lru";
+    const struct replacement_policy *policy;
+    struct trace_reader trace;
+    int mrc_mode = 0;
+    double sample_rate = 1;
+    unsigned long sample_max = 0;
+    int run_count = 4;
+    int thread_count = 1;
+    int protocol = -1;
+    int top = 10;
+    int write_report = 0;
 
-    char *trace_file_name;
-    FILE *trace_file;
-    char action;
-    struct cache_block *cache;
-
-    // Cache datastructures    
-    while ((opt = getopt(argc, argv, "s:E:b:t:")) != -1) {
+    csim_config_default(&config);
+    while ((opt = getopt(argc, argv,
+                         "s:E:b:t:c:r:RS:M:k:j:w:W:p:m:n:CT:Z:x")) != -1) {
         switch(opt) {
             case 's':
-                set_bits = atoi(optarg);
+                config.set_bits = atoi(optarg);
                 break;
             case 'E':
-                number_of_lines = atoi(optarg);
+                config.number_of_lines = atoi(optarg);
                 break;
             case 'b':
-                block_bits = atoi(optarg);
+                config.block_bits = atoi(optarg);
                 break;
             case 't':
                 trace_file_name = optarg;
                 break;
+            case 'c':
+                config_file_name = optarg;
+                break;
+            case 'r':
+                policy_name = optarg;
+                break;
+            case 'R':
+                mrc_mode = 1;
+                break;
+            case 'S':
+                sample_rate = atof(optarg);
+                break;
+            case 'M':
+                sample_max = strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                run_count = atoi(optarg);
+                break;
+            case 'j':
+                thread_count = atoi(optarg);
+                break;
+            case 'w':
+                sweep_file_name = optarg;
+                break;
+            case 'W':
+                if (parse_write_policy(optarg) < 0)
+                    usage();
+                write_report = 1;
+                break;
+            case 'p':
+                if (parse_prefetch(optarg) < 0)
+                    usage();
+                break;
+            case 'm':
+                if (strcmp(optarg, "mesi") == 0)
+                    protocol = PROTOCOL_MESI;
+                else if (strcmp(optarg, "moesi") == 0)
+                    protocol = PROTOCOL_MOESI;
+                else
+                    usage();
+                break;
+            case 'n':
+                top = atoi(optarg);
+                break;
+            case 'C':
+                config.classify = 1;
+                break;
+            case 'T':
+                config.tlb_config = optarg;
+                break;
+            case 'Z':
+                compressed_file_name = optarg;
+                break;
+            case 'x':
+                config.split_blocks = 1;
+                break;
             default:
                 // Assumption: User wants to exit incase wrong 
                 // format is found.
-                printf("Invalid input format. Correct format is: \n");
-                printf("./csim -s <s> -E <E> -b <b> -t <tracefile>\n");
-                exit(1);
+                usage();
         }
     }
+    if (config_file_name == NULL && sweep_file_name == NULL && !mrc_mode &&
+        compressed_file_name == NULL && config.number_of_lines < 1)
+        usage();
+    // Set and block bits leave at least one tag bit of a 64-bit address.
+    if (config.set_bits < 0 || config.block_bits < 0 ||
+        config.set_bits + config.block_bits > 63)
+        usage();
+    if (mrc_mode && (config.set_bits > MRC_MAX_SET_BITS ||
+                     sample_rate <= 0 || sample_rate > 1 || run_count < 1))
+        usage();
+
+    if (protocol >= 0) {
+        policy = replacement_find(policy_name);
+        if (trace_file_name == NULL || policy == NULL ||
+            !replacement_supports(policy, config.number_of_lines))
+            usage();
+        return run_coherence(trace_file_name, protocol, policy, top);
+    }
 
     // Opening tracefile for reading data.
-    trace_file  = fopen(trace_file_name, "r");
     // Assumption: User wishes to exit incase tracefile is not found    
-    if (trace_file == NULL){
+    if (trace_open(&trace, trace_file_name) < 0){
         printf("No valid tracefile found \n");
         exit(2);
     }
-    
-    // Allocate space for cache block.
-    // Ignoring the block offset as it was mentioned.
-    number_of_sets =  (1<<set_bits)*number_of_lines;    
-    cache = malloc(number_of_sets*sizeof(struct cache_block));    
-    if (cache == NULL){
-        // Exiting in case no free space available for malloc or any
-        // other error.
-        printf("Malloc error !");
-        exit(3);
-    }
 
-    // Initialize cache block, setting valid bits to
-    // zero to set it up for initial cold misses. Also
-    // initializing the other variables to zero.
-    for (i = 0; i < (1<<set_bits); i++) {
-        for (j = 0; j < number_of_lines; j++) {
-            (cache+(i+j))->valid = 0;
-            (cache+(i+j))->tag = 0;
-            (cache+(i+j))->block_LRU_count = 0;
-        }
-    }
-    
-    // Scanning each tracefile for loads, stores and modifies.
-    while (fscanf(trace_file," %c %x,%d", &action, &address, &numbytes)>0) {
-        switch(action) {
-            case 'L':
-                // Load case
-                cache_access(cache, address);
-                break;
-            case 'S':
-                // Store case
-                cache_access(cache, address);
-                break;
-            case 'M':
-                // Accessing the cache twice since move is a load
-                // followed by a store
-                cache_access(cache, address);
-                cache_access(cache, address);
-                break;
-            default:
-                // In case rogue space/character(Eg.'I') is encountered 
-                // in the trace file, just continue to next line.
-                continue;
+    if (compressed_file_name != NULL) {
+        if (trace_compress(&trace, compressed_file_name) < 0) {
+            printf("Can't write %s\n", compressed_file_name);
+            exit(2);
         }
+        trace_close(&trace);
+        return 0;
     }
-    fclose(trace_file);
-    free(cache);
-    printSummary(hit_count, miss_count, eviction_count);
-    return 0;
+    if (config_file_name != NULL)
+        return run_hierarchy(&trace, config_file_name);
+    if (sweep_file_name != NULL)
+        return run_sweep(&trace, sweep_file_name, thread_count);
+    if (mrc_mode)
+        return run_mrc(&trace, sample_rate, sample_max, run_count);
+    return run_caches(&trace, policy_name, thread_count, top,
+                      write_report);
 }
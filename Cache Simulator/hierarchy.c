@@ -0,0 +1,449 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Multi-level cache hierarchy for the cache simulator.
+ * An access probes the L1 of its kind and then the
+ * deeper levels until one hits, fills the levels that
+ * missed on the way back and pushes evicted blocks
+ * down into exclusive levels. Inclusive levels
+ * invalidate their victims in all levels above them.
+ * An optional timing model overlaps the misses up to
+ * the number of line fill buffers to estimate the
+ * memory stall cycles of the trace.
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hierarchy.h"
+
+static void fill_level(struct hierarchy *h, int *path, int k,
+                       unsigned long address);
+
+/* Function - parse_policy
+ * Mapping a policy name from the config file to its POLICY_ value.
+ * ---------------------------------------------------
+ * Return value:
+ * The policy, or -1 for an unknown name.
+ * --------------------------------------------------
+ * */
+static int parse_policy(const char *name){
+    if (strcmp(name, "inclusive") == 0)
+        return POLICY_INCLUSIVE;
+    if (strcmp(name, "exclusive") == 0)
+        return POLICY_EXCLUSIVE;
+    if (strcmp(name, "nine") == 0)
+        return POLICY_NINE;
+    return -1;
+}
+
+/* Function - build_paths
+ * Working out which level serves instruction fetches and which
+ * serves data accesses at every depth, checking that each depth
+ * has exactly one of each and that the depths are contiguous.
+ * ---------------------------------------------------
+ * Return value:
+ * 0 on success, -1 if the levels don't form a hierarchy.
+ * --------------------------------------------------
+ * */
+static int build_paths(struct hierarchy *h){
+    int d;
+    int k;
+
+    for (d = 0; d < MAX_LEVELS; d++) {
+        h->instruction_path[d] = -1;
+        h->data_path[d] = -1;
+    }
+    h->depth_count = 0;
+    for (k = 0; k < h->level_count; k++) {
+        struct level *level = h->levels + k;
+        d = level->depth - 1;
+        if (level->type != 'd') {
+            if (h->instruction_path[d] >= 0)
+                return -1;
+            h->instruction_path[d] = k;
+        }
+        if (level->type != 'i') {
+            if (h->data_path[d] >= 0)
+                return -1;
+            h->data_path[d] = k;
+        }
+        if (level->depth > h->depth_count)
+            h->depth_count = level->depth;
+    }
+    for (d = 0; d < h->depth_count; d++) {
+        if (h->instruction_path[d] < 0 || h->data_path[d] < 0)
+            return -1;
+    }
+    // The L1s hold every block they are asked for.
+    for (k = 0; k < h->level_count; k++) {
+        if (h->levels[k].depth == 1 &&
+            h->levels[k].policy == POLICY_EXCLUSIVE)
+            return -1;
+    }
+    return 0;
+}
+
+/* Function - hierarchy_load
+ * Reading the levels of a hierarchy from a config file and
+ * allocating their caches.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Hierarchy to set up and path of the config file.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, -1 on error after printing it to stderr.
+ * --------------------------------------------------
+ * */
+int hierarchy_load(struct hierarchy *h, const char *path){
+    FILE *config = fopen(path, "r");
+    char line[256];
+    char name[LEVEL_NAME_MAX];
+    char type;
+    char option[2][16];
+    int policy;
+    const struct replacement_policy *replacement;
+    int depth, set_bits, number_of_lines, block_bits, latency;
+    int fields;
+    int line_number = 0;
+    int k;
+
+    memset(h, 0, sizeof(*h));
+    h->memory_latency = -1;
+    if (config == NULL) {
+        fprintf(stderr, "%s: can't open hierarchy config\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), config) != NULL) {
+        line_number++;
+        // Dropping comments, then skipping blank lines.
+        line[strcspn(line, "#\n")] = '\0';
+        if (sscanf(line, " %15s", name) != 1)
+            continue;
+
+        if (strcmp(name, "memory") == 0) {
+            if (sscanf(line, " %*s %d", &h->memory_latency) != 1 ||
+                h->memory_latency < 0)
+                goto bad_line;
+            continue;
+        }
+        if (strcmp(name, "fillbuffers") == 0) {
+            fields = sscanf(line, " %*s %d %d", &h->fill_buffer_count,
+                            &h->window);
+            if (fields < 1 || h->fill_buffer_count < 1 ||
+                h->fill_buffer_count > MAX_FILL_BUFFERS || h->window < 0)
+                goto bad_line;
+            continue;
+        }
+
+        fields = sscanf(line, " %*s %d %c %d %d %d %d %15s %15s", &depth,
+                        &type, &set_bits, &number_of_lines, &block_bits,
+                        &latency, option[0], option[1]);
+        if (fields < 6 || h->level_count == MAX_LEVELS ||
+            depth < 1 || depth > MAX_LEVELS ||
+            (type != 'i' && type != 'd' && type != 'u') ||
+            set_bits < 0 || set_bits > 30 || number_of_lines < 1 ||
+            block_bits < 0 || block_bits > 30 || latency < 0)
+            goto bad_line;
+        // The options are an inclusion and a replacement policy, in
+        // either order.
+        policy = POLICY_INCLUSIVE;
+        replacement = replacement_find("lru");
+        for (k = 0; k < fields - 6; k++) {
+            if (parse_policy(option[k]) >= 0)
+                policy = parse_policy(option[k]);
+            else if (replacement_find(option[k]) != NULL)
+                replacement = replacement_find(option[k]);
+            else
+                goto bad_line;
+        }
+        if (!replacement_supports(replacement, number_of_lines)) {
+            fprintf(stderr, "%s:%d: %s needs E to be a power of 2\n",
+                    path, line_number, replacement->name);
+            goto error;
+        }
+        if (h->level_count > 0 &&
+            block_bits != h->levels[0].cache.block_bits) {
+            fprintf(stderr, "%s:%d: all levels need the same block size\n",
+                    path, line_number);
+            goto error;
+        }
+
+        struct level *level = h->levels + h->level_count;
+        strcpy(level->name, name);
+        level->depth = depth;
+        level->type = type;
+        level->policy = policy;
+        level->latency = latency;
+        if (cache_init(&level->cache, set_bits, number_of_lines,
+                       block_bits, replacement) < 0) {
+            fprintf(stderr, "%s:%d: not enough memory for %s\n",
+                    path, line_number, name);
+            goto error;
+        }
+        h->level_count++;
+    }
+    fclose(config);
+
+    if (h->level_count == 0 || h->memory_latency < 0) {
+        fprintf(stderr, "%s: needs at least one level and a memory line\n",
+                path);
+        hierarchy_free(h);
+        return -1;
+    }
+    if (build_paths(h) < 0) {
+        fprintf(stderr, "%s: every depth needs one unified level or an "
+                "'i' and a 'd' level, and L1s can't be exclusive\n", path);
+        hierarchy_free(h);
+        return -1;
+    }
+    return 0;
+
+bad_line:
+    fprintf(stderr, "%s:%d: expected '<name> <depth> <i|d|u> <s> <E> <b> "
+            "<latency> [inclusive|exclusive|nine] [<replacement>]', "
+            "'memory <latency>' or 'fillbuffers <count> [<window>]'\n",
+            path, line_number);
+error:
+    fclose(config);
+    for (k = 0; k < h->level_count; k++)
+        cache_free(&h->levels[k].cache);
+    h->level_count = 0;
+    return -1;
+}
+
+/* Function - hierarchy_free
+ * Releasing the caches of all levels.
+ * */
+void hierarchy_free(struct hierarchy *h){
+    int k;
+
+    for (k = 0; k < h->level_count; k++)
+        cache_free(&h->levels[k].cache);
+    h->level_count = 0;
+}
+
+/* Function - back_invalidate
+ * Dropping a block evicted from an inclusive level from every
+ * level above it, on both the instruction and the data side.
+ * */
+static void back_invalidate(struct hierarchy *h, int depth,
+                            unsigned long address){
+    int k;
+
+    for (k = 0; k < h->level_count; k++) {
+        struct level *level = h->levels + k;
+        if (level->depth < depth && cache_remove(&level->cache, address))
+            level->back_invalidation_count++;
+    }
+}
+
+/* Function - evict
+ * Handling a block evicted from level path[k]: inclusive levels
+ * take it out of the levels above, and an exclusive level right
+ * below catches it.
+ * */
+static void evict(struct hierarchy *h, int *path, int k,
+                  unsigned long victim){
+    struct level *level = h->levels + path[k];
+
+    level->eviction_count++;
+    if (level->policy == POLICY_INCLUSIVE)
+        back_invalidate(h, level->depth, victim);
+    if (k+1 < h->depth_count &&
+        h->levels[path[k+1]].policy == POLICY_EXCLUSIVE)
+        fill_level(h, path, k+1, victim);
+}
+
+/* Function - fill_level
+ * Bringing a block into level path[k] as MRU, unless it is
+ * already there (a victim from the other L1 may be).
+ * */
+static void fill_level(struct hierarchy *h, int *path, int k,
+                       unsigned long address){
+    struct cache *cache = &h->levels[path[k]].cache;
+    unsigned long victim;
+
+    if (cache_lookup(cache, address))
+        return;
+    if (cache_insert(cache, address, &victim))
+        evict(h, path, k, victim);
+}
+
+/* Function - release_fill_buffer
+ * Freeing fill buffer k, the last one taking its place.
+ * */
+static void release_fill_buffer(struct hierarchy *h, int k){
+    h->busy_count--;
+    h->fill_buffers[k] = h->fill_buffers[h->busy_count];
+}
+
+/* Function - stall_until
+ * Moving the core on to 'cycle' if it is later, and freeing
+ * the fill buffers whose misses have completed by then.
+ * */
+static void stall_until(struct hierarchy *h, unsigned long cycle){
+    int k;
+
+    if (cycle > h->now)
+        h->now = cycle;
+    for (k = h->busy_count-1; k >= 0; k--) {
+        if (h->fill_buffers[k].ready <= h->now)
+            release_fill_buffer(h, k);
+    }
+}
+
+/* Function - time_access
+ * Issuing one access in the timing model. Before it can
+ * issue, the core waits for its oldest miss if that is a
+ * window behind, and for a free fill buffer if the access
+ * missed the L1D. An instruction fetch miss holds up the
+ * core until it is served.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Hierarchy, whether the access is an instruction fetch and
+ * its latency below the L1, 0 for an L1 hit.
+ * --------------------------------------------------
+ * */
+static void time_access(struct hierarchy *h, int instruction,
+                        unsigned long latency){
+    int oldest;
+    int k;
+
+    stall_until(h, h->now);
+    while (h->window > 0 && h->busy_count > 0) {
+        oldest = 0;
+        for (k = 1; k < h->busy_count; k++) {
+            if (h->fill_buffers[k].issued < h->fill_buffers[oldest].issued)
+                oldest = k;
+        }
+        if (h->access_count - h->fill_buffers[oldest].issued <
+            (unsigned long)h->window)
+            break;
+        stall_until(h, h->fill_buffers[oldest].ready);
+    }
+
+    if (latency > 0) {
+        h->serial_stall_count += latency;
+        if (instruction) {
+            stall_until(h, h->now + latency);
+        } else {
+            if (h->busy_count == h->fill_buffer_count) {
+                oldest = 0;
+                for (k = 1; k < h->busy_count; k++) {
+                    if (h->fill_buffers[k].ready <
+                        h->fill_buffers[oldest].ready)
+                        oldest = k;
+                }
+                stall_until(h, h->fill_buffers[oldest].ready);
+            }
+            h->fill_buffers[h->busy_count].issued = h->access_count;
+            h->fill_buffers[h->busy_count].ready = h->now + latency;
+            h->busy_count++;
+        }
+    }
+    h->now++;
+}
+
+/* Function - demand_access
+ * One load, store or instruction fetch. Probes the levels on
+ * 'path' until one hits, charging each probe's latency (and
+ * the memory latency if all miss). Then fills the levels that
+ * missed, the deepest first, skipping exclusive ones. A block
+ * found in an exclusive level moves up out of it.
+ * */
+static void demand_access(struct hierarchy *h, int *path,
+                          unsigned long address){
+    unsigned long latency = 0;
+    int k;
+    int hit_depth = h->depth_count;
+
+    h->access_count++;
+    for (k = 0; k < h->depth_count; k++) {
+        struct level *level = h->levels + path[k];
+        h->cycle_count += level->latency;
+        if (k > 0)
+            latency += level->latency;
+        if (cache_lookup(&level->cache, address)) {
+            level->hit_count++;
+            hit_depth = k;
+            break;
+        }
+        level->miss_count++;
+    }
+
+    if (hit_depth == h->depth_count) {
+        h->cycle_count += h->memory_latency;
+        latency += h->memory_latency;
+    } else if (h->levels[path[hit_depth]].policy == POLICY_EXCLUSIVE)
+        cache_remove(&h->levels[path[hit_depth]].cache, address);
+
+    for (k = hit_depth-1; k >= 0; k--) {
+        if (h->levels[path[k]].policy != POLICY_EXCLUSIVE)
+            fill_level(h, path, k, address);
+    }
+    if (h->fill_buffer_count > 0)
+        time_access(h, path == h->instruction_path, latency);
+}
+
+/* Function - hierarchy_access
+ * Simulating one trace operation. Instruction fetches go
+ * through the 'i' side, loads and stores through the 'd'
+ * side, and a modify is a load followed by a store.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Hierarchy, trace operation and address.
+ * --------------------------------------------------
+ * */
+void hierarchy_access(struct hierarchy *h, char op, unsigned long address){
+    switch(op) {
+        case 'I':
+            demand_access(h, h->instruction_path, address);
+            break;
+        case 'L':
+        case 'S':
+            demand_access(h, h->data_path, address);
+            break;
+        case 'M':
+            demand_access(h, h->data_path, address);
+            demand_access(h, h->data_path, address);
+            break;
+    }
+}
+
+/* Function - hierarchy_report
+ * Printing a table of per-level counts followed by the
+ * average memory access time in cycles. With the timing
+ * model, the run ends when the last miss completes, and
+ * every cycle past one per access is a memory stall.
+ * */
+void hierarchy_report(struct hierarchy *h, FILE *out){
+    unsigned long end = h->now;
+    int k;
+
+    fprintf(out, "%-8s %12s %12s %12s %12s %8s\n", "level", "hits",
+            "misses", "evictions", "back-inv", "miss%");
+    for (k = 0; k < h->level_count; k++) {
+        struct level *level = h->levels + k;
+        unsigned long probes = level->hit_count + level->miss_count;
+        fprintf(out, "%-8s %12lu %12lu %12lu %12lu %7.2f%%\n", level->name,
+                level->hit_count, level->miss_count, level->eviction_count,
+                level->back_invalidation_count,
+                probes ? 100.0 * level->miss_count / probes : 0.0);
+    }
+    fprintf(out, "AMAT: %.2f cycles over %lu accesses\n",
+            h->access_count ? (double)h->cycle_count / h->access_count : 0.0,
+            h->access_count);
+    if (h->fill_buffer_count == 0)
+        return;
+    for (k = 0; k < h->busy_count; k++) {
+        if (h->fill_buffers[k].ready > end)
+            end = h->fill_buffers[k].ready;
+    }
+    fprintf(out, "Cycles: %lu, memory stalls: %lu (%lu without overlap) "
+            "with %d fill buffers\n", end, end - h->access_count,
+            h->serial_stall_count, h->fill_buffer_count);
+}
@@ -0,0 +1,118 @@
+/*
+ * hierarchy.h - A multi-level cache hierarchy built from struct cache
+ *
+ * The levels are read from a config file with one level per line:
+ *
+ *     <name> <depth> <i|d|u> <s> <E> <b> <latency> [<policy>] [<replacement>]
+ *     memory <latency>
+ *     fillbuffers <count> [<window>]
+ *
+ * Depth 1 is the L1. A depth has either one unified ('u') level or a
+ * separate instruction ('i') and data ('d') level, and all levels use
+ * the same block size. '#' starts a comment. The replacement policy
+ * is one of replacement.h, LRU by default. The inclusion policy says
+ * how a level relates to the levels above it:
+ * inclusive - Evicting a block also invalidates it above (the default).
+ * exclusive - Only holds blocks evicted from the level above, a hit
+ *             moves the block up.
+ * nine      - Filled on misses like an inclusive level, but evictions
+ *             leave the levels above alone.
+ *
+ * A fillbuffers line turns on the timing model, which estimates the
+ * run time of the trace on a core that issues one access per cycle.
+ * L1 hits are hidden by the pipeline. An L1 data miss takes one of
+ * 'count' line fill buffers for the latency of the levels below the
+ * L1 (and of memory if they miss too), and the core only stalls when
+ * all buffers are taken, or when it is 'window' accesses ahead of its
+ * oldest outstanding miss. With no window, it runs ahead as far as the
+ * buffers allow. Instruction fetch misses stall the core until they
+ * are served.
+ */
+
+#ifndef CSIM_HIERARCHY_H
+#define CSIM_HIERARCHY_H
+
+#include <stdio.h>
+#include "cache.h"
+
+#define MAX_LEVELS 8
+#define LEVEL_NAME_MAX 16
+#define MAX_FILL_BUFFERS 64
+
+#define POLICY_INCLUSIVE 0
+#define POLICY_EXCLUSIVE 1
+#define POLICY_NINE      2
+
+/* Definining the structure level - one cache of the hierarchy.
+ * type - 'i', 'd' or 'u' for instruction, data or unified.
+ * latency - Cycles to probe the level, hit or miss.
+ * hit_count, miss_count - Demand accesses that reached the level.
+ * eviction_count - Valid blocks pushed out of the level.
+ * back_invalidation_count - Blocks dropped from this level because an
+ *                           inclusive level below evicted them.
+ * */
+struct level {
+    char name[LEVEL_NAME_MAX];
+    int depth;
+    char type;
+    int policy;
+    int latency;
+    struct cache cache;
+    unsigned long hit_count;
+    unsigned long miss_count;
+    unsigned long eviction_count;
+    unsigned long back_invalidation_count;
+};
+
+/* Definining the structure hierarchy.
+ * instruction_path, data_path - Indices into levels of the caches an
+ *                               instruction fetch or a data access
+ *                               probes, L1 first.
+ * access_count, cycle_count - Demand accesses and the cycles they
+ *                             took, for the AMAT.
+ * fill_buffer_count - Line fill buffers of the timing model, 0 if it
+ *                     is off.
+ * window - Accesses the core runs ahead of its oldest miss, 0 for no
+ *          limit.
+ * fill_buffers, busy_count - Outstanding misses, with the access that
+ *                            issued each and the cycle it completes.
+ * now - Cycle the next access issues at.
+ * serial_stall_count - Miss latencies added up, what the core would
+ *                      stall for if misses didn't overlap.
+ * */
+struct hierarchy {
+    int level_count;
+    int depth_count;
+    struct level levels[MAX_LEVELS];
+    int instruction_path[MAX_LEVELS];
+    int data_path[MAX_LEVELS];
+    int memory_latency;
+    unsigned long access_count;
+    unsigned long cycle_count;
+    int fill_buffer_count;
+    int window;
+    int busy_count;
+    struct {
+        unsigned long issued;
+        unsigned long ready;
+    } fill_buffers[MAX_FILL_BUFFERS];
+    unsigned long now;
+    unsigned long serial_stall_count;
+};
+
+/* Reads a config file and sets up empty caches, returns 0 on success
+ * and -1 after printing the problem to stderr */
+int hierarchy_load(struct hierarchy *h, const char *path);
+
+/* Releases the caches of a hierarchy */
+void hierarchy_free(struct hierarchy *h);
+
+/* Simulates one access, 'op' being a trace operation ('I', 'L', 'S'
+ * or 'M') */
+void hierarchy_access(struct hierarchy *h, char op, unsigned long address);
+
+/* Prints the per-level counts and the AMAT, and the estimated cycles
+ * and memory stalls if the timing model is on */
+void hierarchy_report(struct hierarchy *h, FILE *out);
+
+#endif /* CSIM_HIERARCHY_H */
@@ -0,0 +1,262 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Library interface of the cache simulator. A struct
+ * csim bundles a cache with its prefetcher, miss
+ * classifier and TLBs, and runs trace operations on
+ * them the way csim does for a single level cache.
+ * There is no global state, so simulators can be run
+ * side by side and on different threads.
+ ********************************************************/
+
+#include <string.h>
+#include "libcsim.h"
+
+/* Function - csim_config_default
+ * Filling in the defaults of csim's options.
+ * */
+void csim_config_default(struct csim_config *config){
+    memset(config, 0, sizeof(struct csim_config));
+    config->policy = replacement_find("lru");
+    config->write_back = 1;
+    config->write_allocate = 1;
+    config->prefetch_kind = PREFETCH_NONE;
+    config->prefetch_degree = 1;
+    config->prefetch_latency = 20;
+}
+
+/* Function - csim_init
+ * Checking a config and setting up the cache and whatever
+ * goes with it.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Simulator to set up and its config.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, CSIM_BAD_CONFIG for a geometry, policy or
+ * combination that can't be simulated, CSIM_NO_MEMORY if
+ * an allocation failed and CSIM_BAD_TLB if the TLB config
+ * can't be read.
+ * --------------------------------------------------
+ * */
+int csim_init(struct csim *sim, const struct csim_config *config){
+    memset(sim, 0, sizeof(struct csim));
+    // Set and block bits leave at least one tag bit of a 64-bit address.
+    if (config->set_bits < 0 || config->block_bits < 0 ||
+        config->set_bits + config->block_bits > 63 ||
+        config->number_of_lines < 1 || config->policy == NULL ||
+        !replacement_supports(config->policy, config->number_of_lines) ||
+        config->prefetch_kind < 0 || config->prefetch_degree < 1 ||
+        config->prefetch_latency < 0)
+        return CSIM_BAD_CONFIG;
+    // Prefetched blocks can hit on their first access, which the
+    // classifier would miss, so the two don't go together.
+    if (config->classify && config->prefetch_kind != PREFETCH_NONE)
+        return CSIM_BAD_CONFIG;
+
+    if (cache_init(&sim->cache, config->set_bits, config->number_of_lines,
+                   config->block_bits, config->policy) < 0)
+        return CSIM_NO_MEMORY;
+    sim->cache.write_back = config->write_back;
+    sim->cache.write_allocate = config->write_allocate;
+    if (prefetcher_init(&sim->prefetcher, config->prefetch_kind,
+                        config->prefetch_degree,
+                        config->prefetch_latency) < 0) {
+        csim_free(sim);
+        return CSIM_NO_MEMORY;
+    }
+    if (config->classify) {
+        if (classify_init(&sim->classifier, &sim->cache) < 0) {
+            csim_free(sim);
+            return CSIM_NO_MEMORY;
+        }
+        sim->classify = 1;
+    }
+    if (config->tlb_config != NULL) {
+        if (tlb_load(&sim->tlb, config->tlb_config) < 0) {
+            csim_free(sim);
+            return CSIM_BAD_TLB;
+        }
+        sim->tlb_mode = 1;
+    }
+    sim->split_blocks = config->split_blocks;
+    return 0;
+}
+
+/* Function - csim_free
+ * Releasing everything csim_init set up.
+ * */
+void csim_free(struct csim *sim){
+    if (sim->classify)
+        classify_free(&sim->classifier);
+    if (sim->tlb_mode)
+        tlb_free(&sim->tlb);
+    prefetcher_free(&sim->prefetcher);
+    cache_free(&sim->cache);
+    sim->classify = 0;
+    sim->tlb_mode = 0;
+}
+
+/* Function - data_access
+ * Running one load or store of the current instruction
+ * through the prefetcher or straight to the cache, and
+ * classifying it.
+ * ---------------------------------------------------
+ * Return value:
+ * Non-zero on a hit, -1 if the classifier ran out of memory.
+ * --------------------------------------------------
+ * */
+static int data_access(struct csim *sim, unsigned long address, int write,
+                       unsigned size){
+    int result;
+
+    if (sim->prefetcher.kind != PREFETCH_NONE)
+        result = prefetcher_access(&sim->prefetcher, &sim->cache, sim->pc,
+                                   address, write, size);
+    else if (write)
+        result = cache_store(&sim->cache, address, size);
+    else
+        result = cache_access(&sim->cache, address);
+    if (sim->classify &&
+        classify_access(&sim->classifier, address, result) < 0)
+        return -1;
+    return result != 0;
+}
+
+/* Function - translate
+ * Translating the address of a data access before it goes
+ * to the cache. The page table reads of a TLB miss go
+ * through the cache too if the walk is cached, and cost
+ * what the cache made of them.
+ * ---------------------------------------------------
+ * Return value:
+ * 0, or -1 if the classifier ran out of memory.
+ * --------------------------------------------------
+ * */
+static int translate(struct csim *sim, unsigned long address){
+    unsigned long walk[TLB_WALK_MAX];
+    int count = tlb_translate(&sim->tlb, address, walk);
+    int hit = 0;
+    int k;
+
+    for (k = 0; k < count; k++) {
+        if (sim->tlb.walk_cached)
+            hit = data_access(sim, walk[k], 0, 0);
+        if (hit < 0)
+            return -1;
+        tlb_walk_read(&sim->tlb, hit);
+    }
+    return 0;
+}
+
+/* Function - reference
+ * Translating and running one load or store. With
+ * split_blocks, an access whose bytes run past the end of
+ * its block becomes one access per block it touches, each
+ * with its share of the bytes, and is counted as split.
+ * ---------------------------------------------------
+ * Return value:
+ * 1 if every block hit, 0 if one missed and -1 if the
+ * classifier ran out of memory.
+ * --------------------------------------------------
+ * */
+static int reference(struct csim *sim, unsigned long address, int write,
+                     unsigned size){
+    unsigned long block_size = 1UL << sim->cache.block_bits;
+    unsigned long offset = address & (block_size - 1);
+    unsigned piece;
+    int hit = 1;
+    int result;
+
+    if (!sim->split_blocks || offset + size <= block_size) {
+        if (sim->tlb_mode && translate(sim, address) < 0)
+            return -1;
+        return data_access(sim, address, write, size);
+    }
+
+    sim->split_count++;
+    while (size > 0) {
+        piece = block_size - offset < size ? block_size - offset : size;
+        if (sim->tlb_mode && translate(sim, address) < 0)
+            return -1;
+        if ((result = data_access(sim, address, write, piece)) < 0)
+            return -1;
+        hit &= result;
+        address += piece;
+        size -= piece;
+        offset = 0;
+    }
+    return hit;
+}
+
+/* Function - csim_access
+ * Simulating one trace operation. A modify is a load
+ * followed by a store, and instruction fetches only set
+ * the instruction the next data accesses belong to.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Simulator, operation, address and size in bytes.
+ * --------------------------------------------------
+ * Return value:
+ * 1 if the first data access hit, 0 otherwise and -1 if
+ * the classifier ran out of memory.
+ * --------------------------------------------------
+ * */
+int csim_access(struct csim *sim, char op, unsigned long address,
+                unsigned size){
+    int hit;
+
+    switch(op) {
+        case 'L':
+        case 'S':
+        case 'M':
+            hit = reference(sim, address, op == 'S', size);
+            if (op != 'M' || hit < 0)
+                return hit;
+            if (reference(sim, address, 1, size) < 0)
+                return -1;
+            return hit;
+        default:
+            sim->pc = address;
+            return 0;
+    }
+}
+
+/* Function - csim_access_batch
+ * Simulating a batch of trace operations in order.
+ * ---------------------------------------------------
+ * Return value:
+ * 0, or -1 if the classifier ran out of memory.
+ * --------------------------------------------------
+ * */
+int csim_access_batch(struct csim *sim, const struct trace_access *batch,
+                      int count){
+    int k;
+
+    for (k = 0; k < count; k++) {
+        if (csim_access(sim, batch[k].op, batch[k].address,
+                        batch[k].size) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Function - csim_get_stats
+ * Copying out the counts of the cache and of whatever goes
+ * with it.
+ * */
+void csim_get_stats(const struct csim *sim, struct csim_stats *stats){
+    memset(stats, 0, sizeof(struct csim_stats));
+    stats->counts = sim->cache.counts;
+    stats->prefetch_late_count = sim->prefetcher.late_count;
+    if (sim->classify) {
+        stats->compulsory_count = sim->classifier.total.compulsory_count;
+        stats->capacity_count = sim->classifier.total.capacity_count;
+        stats->conflict_count = sim->classifier.total.conflict_count;
+    }
+    if (sim->tlb_mode)
+        stats->tlb_cycle_count = sim->tlb.cycle_count;
+    stats->split_count = sim->split_count;
+}
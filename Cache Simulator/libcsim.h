@@ -0,0 +1,135 @@
+/*
+ * libcsim.h - Reentrant single level cache simulator
+ *
+ * A struct csim is one cache together with what csim puts around it:
+ * an optional prefetcher, 3C miss classification and TLBs. It keeps
+ * all of its state to itself, so any number of simulators can run in
+ * one process, each on its own thread if need be.
+ *
+ *     struct csim_config config;
+ *     struct csim sim;
+ *     struct csim_stats stats;
+ *
+ *     csim_config_default(&config);
+ *     config.set_bits = 5;
+ *     config.number_of_lines = 1;
+ *     config.block_bits = 5;
+ *     if (csim_init(&sim, &config) < 0)
+ *         ...
+ *     csim_access(&sim, 'L', address, 4);
+ *     csim_access_batch(&sim, batch, count);
+ *     csim_get_stats(&sim, &stats);
+ *     csim_free(&sim);
+ *
+ * Accesses are the operations of a trace file (see trace.h): I sets
+ * the instruction that the data accesses after it belong to, L loads,
+ * S stores and M does both.
+ */
+
+#ifndef CSIM_LIBCSIM_H
+#define CSIM_LIBCSIM_H
+
+#include "cache.h"
+#include "trace.h"
+#include "prefetch.h"
+#include "classify.h"
+#include "tlb.h"
+
+/* What csim_init returns when it fails */
+#define CSIM_BAD_CONFIG -1
+#define CSIM_NO_MEMORY  -2
+#define CSIM_BAD_TLB    -3
+
+/* Definining the structure csim config - everything a simulator is
+ * made from.
+ * set_bits, number_of_lines, block_bits - Geometry (s, E, b).
+ * policy - Replacement policy, which has to support E.
+ * write_back, write_allocate - Write policy, see struct cache.
+ * prefetch_kind, prefetch_degree, prefetch_latency - Prefetcher, see
+ *                                                    prefetch.h.
+ * classify - Set to classify the misses (see classify.h), which
+ *            can't be done with a prefetcher.
+ * tlb_config - Path of a TLB config file (see tlb.h), or NULL.
+ * split_blocks - Set to run an access on every block its bytes touch,
+ *                not just on the block of its address.
+ * */
+struct csim_config {
+    int set_bits;
+    int number_of_lines;
+    int block_bits;
+    const struct replacement_policy *policy;
+    int write_back;
+    int write_allocate;
+    int prefetch_kind;
+    int prefetch_degree;
+    int prefetch_latency;
+    int classify;
+    const char *tlb_config;
+    int split_blocks;
+};
+
+/* Definining the structure csim - one simulator.
+ * pc - Address of the last instruction fetch.
+ * split_count - Data accesses that touched more than one block, with
+ *               split_blocks.
+ * */
+struct csim {
+    struct cache cache;
+    struct prefetcher prefetcher;
+    int classify;
+    struct classifier classifier;
+    int tlb_mode;
+    struct tlb tlb;
+    unsigned long pc;
+    int split_blocks;
+    unsigned long split_count;
+};
+
+/* Definining the structure csim stats - what the accesses so far
+ * added up to.
+ * counts - Those of the cache.
+ * prefetch_late_count - Prefetched blocks used before they arrived.
+ * compulsory_count, capacity_count, conflict_count - The misses by
+ *                                                    kind, if they
+ *                                                    are classified.
+ * tlb_cycle_count - Cycles spent translating, with TLBs.
+ * split_count - Data accesses split between blocks.
+ * */
+struct csim_stats {
+    struct cache_counts counts;
+    unsigned long prefetch_late_count;
+    unsigned long compulsory_count;
+    unsigned long capacity_count;
+    unsigned long conflict_count;
+    unsigned long tlb_cycle_count;
+    unsigned long split_count;
+};
+
+/* Fills in an LRU write-back, write-allocate cache with no extras
+ * and no lines, to be given a geometry */
+void csim_config_default(struct csim_config *config);
+
+/* Sets up a simulator, returns 0 on success or a CSIM_ error.
+ * Problems with the TLB config are printed to stderr. The classifier
+ * points into the simulator, so it mustn't be moved afterwards. */
+int csim_init(struct csim *sim, const struct csim_config *config);
+
+/* Releases a simulator */
+void csim_free(struct csim *sim);
+
+/* Simulates one trace operation. Returns 1 if its (first) data
+ * access hit, 0 if it missed or was an instruction fetch, and -1 if
+ * the classifier ran out of memory. A split access hits if all of
+ * its blocks do. */
+int csim_access(struct csim *sim, char op, unsigned long address,
+                unsigned size);
+
+/* Simulates 'count' decoded trace lines in order, returns 0 or -1
+ * like csim_access */
+int csim_access_batch(struct csim *sim, const struct trace_access *batch,
+                      int count);
+
+/* Copies out the counts so far */
+void csim_get_stats(const struct csim *sim, struct csim_stats *stats);
+
+#endif /* CSIM_LIBCSIM_H */
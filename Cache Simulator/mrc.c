@@ -0,0 +1,553 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Single pass miss ratio curves for the cache
+ * simulator. Every set keeps a table from block to
+ * the timestamp of its latest access and a Fenwick
+ * tree with a 1 at each of those timestamps. The
+ * stack distance of an access is the number of 1s
+ * after the block's previous timestamp, one prefix
+ * sum away. When the timestamps run out, the live
+ * ones are renumbered 1..n and the tree is rebuilt,
+ * so memory stays proportional to the number of
+ * distinct blocks rather than the trace length.
+ * Sampled curves track only the blocks whose hash is
+ * below a threshold and scale what they see by the
+ * sampling rate. A max-heap of the tracked hashes
+ * lets the threshold drop when a sample limit is hit.
+ ********************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mrc.h"
+
+/* Function - fenwick_add
+ * Adding 'delta' at timestamp 'i'.
+ * */
+static void fenwick_add(struct reuse_stack *stack, unsigned i, int delta){
+    for (; i <= stack->capacity; i += i & -i)
+        stack->fenwick[i] += delta;
+}
+
+/* Function - fenwick_prefix
+ * Number of marked timestamps in 1..i.
+ * */
+static unsigned fenwick_prefix(struct reuse_stack *stack, unsigned i){
+    unsigned sum = 0;
+
+    for (; i > 0; i -= i & -i)
+        sum += stack->fenwick[i];
+    return sum;
+}
+
+/* Function - block_home
+ * Home slot of a block in a table of 'table_size' slots.
+ * */
+static inline unsigned block_home(unsigned long block, unsigned table_size){
+    return (unsigned)((block * 0x9e3779b97f4a7c15UL) >> 32) &
+           (table_size-1);
+}
+
+/* Function - block_slot
+ * Finding the table slot of a block, or the empty slot it
+ * would go into.
+ * */
+static struct reuse_entry *block_slot(struct reuse_entry *table,
+                                      unsigned table_size,
+                                      unsigned long block){
+    unsigned slot = block_home(block, table_size);
+
+    while (table[slot].time != 0 && table[slot].block != block)
+        slot = (slot+1) & (table_size-1);
+    return table + slot;
+}
+
+/* Function - grow_table
+ * Doubling the block table of a stack, which starts out with
+ * 16 slots.
+ * */
+static int grow_table(struct reuse_stack *stack){
+    unsigned size = stack->table_size ? 2*stack->table_size : 16;
+    struct reuse_entry *table = calloc(size, sizeof(struct reuse_entry));
+    unsigned i;
+
+    if (table == NULL)
+        return -1;
+    for (i = 0; i < stack->table_size; i++) {
+        if (stack->table[i].time != 0)
+            *block_slot(table, size, stack->table[i].block) =
+                stack->table[i];
+    }
+    free(stack->table);
+    stack->table = table;
+    stack->table_size = size;
+    return 0;
+}
+
+/* Function - renumber
+ * Giving the latest accesses of the blocks the timestamps
+ * 1..block_count in their order, and rebuilding the tree
+ * with room for as many timestamps again. A live timestamp
+ * t becomes the number of live timestamps up to t, which a
+ * running count over a map of them gives without sorting.
+ * The tree of all 1s is built in linear time too.
+ * */
+static int renumber(struct reuse_stack *stack){
+    unsigned capacity = 2*stack->block_count + 64;
+    unsigned *rank;
+    unsigned *fenwick;
+    unsigned i, j, n = 0;
+
+    rank = calloc(stack->capacity + 1, sizeof(unsigned));
+    fenwick = calloc(capacity + 1, sizeof(unsigned));
+    if (rank == NULL || fenwick == NULL) {
+        free(rank);
+        free(fenwick);
+        return -1;
+    }
+    for (i = 0; i < stack->table_size; i++) {
+        if (stack->table[i].time != 0)
+            rank[stack->table[i].time] = 1;
+    }
+    for (i = 1; i <= stack->capacity; i++) {
+        n += rank[i];
+        rank[i] = n;
+    }
+    for (i = 0; i < stack->table_size; i++) {
+        if (stack->table[i].time != 0)
+            stack->table[i].time = rank[stack->table[i].time];
+    }
+    free(rank);
+
+    for (i = 1; i <= capacity; i++) {
+        fenwick[i] += (i <= n);
+        j = i + (i & -i);
+        if (j <= capacity)
+            fenwick[j] += fenwick[i];
+    }
+    free(stack->fenwick);
+    stack->fenwick = fenwick;
+    stack->capacity = capacity;
+    stack->now = n;
+    return 0;
+}
+
+/* Function - stack_access
+ * Recording an access to a block in the stack of its set.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Stack, block number and where to store the distance.
+ * --------------------------------------------------
+ * Return value:
+ * 1 if the block was seen before, 0 on its first access,
+ * -1 if memory ran out.
+ * --------------------------------------------------
+ * */
+static int stack_access(struct reuse_stack *stack, unsigned long block,
+                        unsigned long *distance){
+    struct reuse_entry *entry;
+    int seen;
+
+    if (2*(stack->block_count+1) > stack->table_size &&
+        grow_table(stack) < 0)
+        return -1;
+    if (stack->now == stack->capacity && renumber(stack) < 0)
+        return -1;
+
+    entry = block_slot(stack->table, stack->table_size, block);
+    seen = (entry->time != 0);
+    if (seen) {
+        // Blocks used after the previous access, each has one mark.
+        *distance = stack->block_count - fenwick_prefix(stack, entry->time);
+        fenwick_add(stack, entry->time, -1);
+    } else {
+        entry->block = block;
+        stack->block_count++;
+    }
+    entry->time = ++stack->now;
+    fenwick_add(stack, entry->time, 1);
+    return seen;
+}
+
+/* Function - stack_remove
+ * Dropping a block from the stack of its set, when it is no
+ * longer sampled. The table entries after it in the probe run
+ * are shifted back, so lookups never need tombstones.
+ * */
+static void stack_remove(struct reuse_stack *stack, unsigned long block){
+    unsigned mask = stack->table_size-1;
+    unsigned hole;
+    unsigned slot;
+    unsigned home;
+
+    if (stack->table_size == 0)
+        return;
+    hole = block_slot(stack->table, stack->table_size, block) - stack->table;
+    if (stack->table[hole].time == 0)
+        return;
+    fenwick_add(stack, stack->table[hole].time, -1);
+    stack->block_count--;
+    for (slot = (hole+1) & mask; stack->table[slot].time != 0;
+         slot = (slot+1) & mask) {
+        home = block_home(stack->table[slot].block, stack->table_size);
+        // Move the entry unless its home lies cyclically in (hole, slot]
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            stack->table[hole] = stack->table[slot];
+            hole = slot;
+        }
+    }
+    stack->table[hole].time = 0;
+}
+
+/* Function - sample_hash
+ * Sampling hash of a block, uniform in [0, MRC_HASH_RANGE).
+ * A salted splitmix64 finalizer, so different seeds give
+ * independent samples.
+ * */
+static unsigned long sample_hash(struct mrc *mrc, unsigned long block){
+    unsigned long x = block + mrc->seed * 0x9e3779b97f4a7c15UL;
+
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9UL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebUL;
+    x ^= x >> 31;
+    return x >> 40;
+}
+
+/* Function - heap_push
+ * Adding a tracked block to the max-heap of sampling hashes.
+ * */
+static void heap_push(struct mrc *mrc, unsigned long hash,
+                      unsigned long block){
+    unsigned long i = mrc->sample_count++;
+    unsigned long parent;
+
+    while (i > 0) {
+        parent = (i-1) / 2;
+        if (mrc->heap[parent].hash >= hash)
+            break;
+        mrc->heap[i] = mrc->heap[parent];
+        i = parent;
+    }
+    mrc->heap[i].hash = hash;
+    mrc->heap[i].block = block;
+}
+
+/* Function - heap_pop
+ * Taking the block with the largest hash off the heap.
+ * */
+static struct sample heap_pop(struct mrc *mrc){
+    struct sample top = mrc->heap[0];
+    struct sample last = mrc->heap[--mrc->sample_count];
+    unsigned long i = 0;
+    unsigned long child;
+
+    while ((child = 2*i + 1) < mrc->sample_count) {
+        if (child+1 < mrc->sample_count &&
+            mrc->heap[child+1].hash > mrc->heap[child].hash)
+            child++;
+        if (mrc->heap[child].hash <= last.hash)
+            break;
+        mrc->heap[i] = mrc->heap[child];
+        i = child;
+    }
+    mrc->heap[i] = last;
+    return top;
+}
+
+/* Function - mrc_init
+ * Setting up empty stacks for 1 up to 2^max_set_bits sets.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Curves to set up, largest s, b, sampling rate, most blocks
+ * to sample (0 for no limit) and seed of the sampling hash.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if the memory couldn't be allocated.
+ * --------------------------------------------------
+ * */
+int mrc_init(struct mrc *mrc, int max_set_bits, int block_bits,
+             double rate, unsigned long sample_max, unsigned long seed){
+    int s;
+
+    memset(mrc, 0, sizeof(*mrc));
+    mrc->block_bits = block_bits;
+    mrc->max_set_bits = max_set_bits;
+    mrc->threshold = (unsigned long)(rate * MRC_HASH_RANGE + 0.5);
+    if (mrc->threshold < 1)
+        mrc->threshold = 1;
+    if (mrc->threshold > MRC_HASH_RANGE)
+        mrc->threshold = MRC_HASH_RANGE;
+    mrc->seed = seed;
+    mrc->sample_max = sample_max;
+    if (sample_max != 0) {
+        mrc->heap = malloc((sample_max + 1) * sizeof(struct sample));
+        if (mrc->heap == NULL)
+            return -1;
+    }
+    for (s = 0; s <= max_set_bits; s++) {
+        mrc->levels[s].set_bits = s;
+        // Stacks are zeroed and only get memory on their first access.
+        mrc->levels[s].stacks = calloc(1UL << s, sizeof(struct reuse_stack));
+        if (mrc->levels[s].stacks == NULL) {
+            mrc_free(mrc);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Function - record
+ * Adding 'weight' accesses at a (scaled) distance to the
+ * histogram of a level, growing it or widening its bins.
+ * */
+static int record(struct mrc_level *level, double distance, double weight){
+    unsigned long bin = (unsigned long)distance >> level->bin_shift;
+    unsigned long size;
+    unsigned long i;
+    double *histogram;
+
+    while (bin >= MRC_MAX_BINS) {
+        // Merging pairs of bins into bins twice as wide.
+        for (i = 0; i < level->histogram_size / 2; i++)
+            level->histogram[i] = level->histogram[2*i] +
+                                  level->histogram[2*i + 1];
+        for (; i < level->histogram_size; i++)
+            level->histogram[i] = 0;
+        level->bin_shift++;
+        bin >>= 1;
+    }
+    if (bin >= level->histogram_size) {
+        for (size = level->histogram_size ? level->histogram_size : 64;
+             size <= bin; )
+            size *= 2;
+        histogram = realloc(level->histogram, size * sizeof(*histogram));
+        if (histogram == NULL)
+            return -1;
+        for (i = level->histogram_size; i < size; i++)
+            histogram[i] = 0;
+        level->histogram = histogram;
+        level->histogram_size = size;
+    }
+    level->histogram[bin] += weight;
+    return 0;
+}
+
+/* Function - drop_samples
+ * Enforcing the sample limit: lowering the threshold to the
+ * largest tracked hash and dropping every block at or above
+ * it from all stacks.
+ * */
+static void drop_samples(struct mrc *mrc){
+    struct sample dropped;
+    int s;
+
+    mrc->threshold = mrc->heap[0].hash;
+    while (mrc->sample_count > 0 && mrc->heap[0].hash >= mrc->threshold) {
+        dropped = heap_pop(mrc);
+        for (s = 0; s <= mrc->max_set_bits; s++) {
+            struct mrc_level *level = mrc->levels + s;
+            stack_remove(level->stacks +
+                         (dropped.block & ((1UL << s) - 1)), dropped.block);
+        }
+    }
+}
+
+/* Function - mrc_access
+ * Recording the distance of an access for every set count,
+ * if its block is sampled.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Curves and address.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if memory ran out.
+ * --------------------------------------------------
+ * */
+int mrc_access(struct mrc *mrc, unsigned long address){
+    unsigned long block = address >> mrc->block_bits;
+    unsigned long hash = sample_hash(mrc, block);
+    unsigned long distance = 0;
+    struct reuse_stack *all = mrc->levels[0].stacks;
+    double weight;
+    int s;
+    int seen;
+
+    mrc->access_count++;
+    if (hash >= mrc->threshold)
+        return 0;
+    if (mrc->sample_max != 0 &&
+        (all->table_size == 0 ||
+         block_slot(all->table, all->table_size, block)->time == 0)) {
+        // A new block, which may push the sample over its limit.
+        heap_push(mrc, hash, block);
+        if (mrc->sample_count > mrc->sample_max) {
+            drop_samples(mrc);
+            if (hash >= mrc->threshold)
+                return 0;
+        }
+    }
+
+    weight = (double)MRC_HASH_RANGE / mrc->threshold;
+    for (s = 0; s <= mrc->max_set_bits; s++) {
+        struct mrc_level *level = mrc->levels + s;
+        seen = stack_access(level->stacks + (block & ((1UL << s) - 1)),
+                            block, &distance);
+        if (seen < 0)
+            return -1;
+        level->sampled_weight += weight;
+        if (seen && record(level, distance * weight, weight) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Function - mrc_sample_empty
+ * Checking whether sampling missed every block of a trace
+ * with accesses. Every sampled access adds to the weight
+ * of all levels, so looking at one set count is enough.
+ * */
+int mrc_sample_empty(struct mrc *mrc){
+    return mrc->access_count > 0 && mrc->levels[0].sampled_weight == 0;
+}
+
+/* Function - mrc_miss_ratio
+ * Estimating the miss ratio of 2^set_bits sets of 'ways'
+ * lines. The accesses a sample over- or under-represents
+ * are counted at distance 0 (the SHARDS adjustment), and
+ * a bin that 'ways' splits counts in proportion.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Curves, s and E.
+ * --------------------------------------------------
+ * Return value:
+ * Miss ratio between 0 and 1.
+ * --------------------------------------------------
+ * */
+double mrc_miss_ratio(struct mrc *mrc, int set_bits, unsigned long ways){
+    struct mrc_level *level = mrc->levels + set_bits;
+    unsigned long width = 1UL << level->bin_shift;
+    unsigned long bin;
+    double hits = mrc->access_count - level->sampled_weight;
+    double ratio;
+
+    if (mrc->access_count == 0)
+        return 0;
+    for (bin = 0; bin < level->histogram_size; bin++) {
+        if ((bin+1) * width <= ways) {
+            hits += level->histogram[bin];
+        } else {
+            if (bin * width < ways)
+                hits += level->histogram[bin] * (ways - bin*width) / width;
+            break;
+        }
+    }
+    ratio = 1 - hits / mrc->access_count;
+    return ratio < 0 ? 0 : (ratio > 1 ? 1 : ratio);
+}
+
+/* Function - mrc_write_csv
+ * Writing 'sets,ways,bytes,miss_ratio' rows. A cache with E
+ * ways misses on the accesses with a distance of E or more,
+ * so for each set count the ratio only changes at the ways
+ * just past a distance that occurred, and only those rows
+ * (and E=1) are written.
+ * */
+void mrc_write_csv(struct mrc *mrc, FILE *out){
+    unsigned long bin;
+    unsigned long ways;
+    unsigned long sets;
+    double misses;
+    int s;
+
+    fprintf(out, "sets,ways,bytes,miss_ratio\n");
+    if (mrc->access_count == 0)
+        return;
+    for (s = 0; s <= mrc->max_set_bits; s++) {
+        struct mrc_level *level = mrc->levels + s;
+        sets = 1UL << s;
+        misses = mrc->access_count;
+        for (bin = 0; bin < level->histogram_size; bin++) {
+            // Distances below 'ways' hit.
+            misses -= level->histogram[bin];
+            ways = (bin+1) << level->bin_shift;
+            if (bin == 0 || level->histogram[bin] != 0)
+                fprintf(out, "%lu,%lu,%lu,%.6f\n", sets, ways,
+                        (sets * ways) << mrc->block_bits,
+                        misses / mrc->access_count);
+        }
+        if (level->histogram_size == 0)
+            fprintf(out, "%lu,1,%lu,%.6f\n", sets, sets << mrc->block_bits,
+                    misses / mrc->access_count);
+    }
+}
+
+/* Function - mrc_write_sampled_csv
+ * Writing 'sets,ways,bytes,miss_ratio,stddev' rows for every
+ * power of 2 associativity up to the longest distance seen,
+ * with the mean and sample standard deviation of the
+ * estimates of runs that sampled with different seeds.
+ * */
+void mrc_write_sampled_csv(struct mrc *runs, int run_count, FILE *out){
+    unsigned long ways;
+    unsigned long max_ways;
+    unsigned long sets;
+    double ratio, sum, square_sum, mean, stddev;
+    int s;
+    int r;
+
+    fprintf(out, "sets,ways,bytes,miss_ratio,stddev\n");
+    for (s = 0; s <= runs[0].max_set_bits; s++) {
+        sets = 1UL << s;
+        max_ways = 1;
+        for (r = 0; r < run_count; r++) {
+            struct mrc_level *level = runs[r].levels + s;
+            if ((level->histogram_size << level->bin_shift) > max_ways)
+                max_ways = level->histogram_size << level->bin_shift;
+        }
+        for (ways = 1; ; ways *= 2) {
+            sum = 0;
+            square_sum = 0;
+            for (r = 0; r < run_count; r++) {
+                ratio = mrc_miss_ratio(runs + r, s, ways);
+                sum += ratio;
+                square_sum += ratio * ratio;
+            }
+            mean = sum / run_count;
+            stddev = 0;
+            if (run_count > 1 && square_sum > mean * sum)
+                stddev = sqrt((square_sum - mean * sum) / (run_count - 1));
+            fprintf(out, "%lu,%lu,%lu,%.6f,%.6f\n", sets, ways,
+                    (sets * ways) << runs[0].block_bits, mean, stddev);
+            if (ways >= max_ways)
+                break;
+        }
+    }
+}
+
+/* Function - mrc_free
+ * Releasing the stacks, histograms and sample heap.
+ * */
+void mrc_free(struct mrc *mrc){
+    unsigned long i;
+    int s;
+
+    for (s = 0; s <= mrc->max_set_bits; s++) {
+        struct mrc_level *level = mrc->levels + s;
+        if (level->stacks != NULL) {
+            for (i = 0; i < (1UL << s); i++) {
+                free(level->stacks[i].table);
+                free(level->stacks[i].fenwick);
+            }
+        }
+        free(level->stacks);
+        free(level->histogram);
+        level->stacks = NULL;
+        level->histogram = NULL;
+    }
+    free(mrc->heap);
+    mrc->heap = NULL;
+}
@@ -0,0 +1,129 @@
+/*
+ * mrc.h - Miss ratio curves from LRU stack distances
+ *
+ * The stack distance of an access is the number of distinct blocks
+ * used since the previous access to the same block. An LRU cache of
+ * C blocks misses exactly on the accesses with a distance of C or
+ * more (and on first accesses), so one pass over a trace gives the
+ * miss ratio of every fully associative capacity. Keeping a separate
+ * stack per set gives the same for every associativity of a set
+ * associative cache with 2^s sets.
+ *
+ * Distances are found with a Fenwick tree over access timestamps
+ * that marks the latest access of every block, so each access takes
+ * O(log n) time.
+ *
+ * For traces with too many blocks for that, the curves can be made
+ * from a spatial sample (SHARDS): only blocks whose hash is below a
+ * threshold are tracked, at rate R = threshold / MRC_HASH_RANGE, and
+ * every sampled distance and access stands for 1/R of them. With a
+ * sample limit the threshold drops to keep at most that many blocks,
+ * which bounds memory whatever the trace.
+ */
+
+#ifndef CSIM_MRC_H
+#define CSIM_MRC_H
+
+#include <stdio.h>
+
+/* Largest number of set bits curves can be made for */
+#define MRC_MAX_SET_BITS 16
+
+/* Sampling hashes are taken modulo this */
+#define MRC_HASH_RANGE (1UL << 24)
+
+/* Histograms keep at most this many bins and double their bin width
+ * when a longer distance comes along */
+#define MRC_MAX_BINS (1UL << 22)
+
+/* Definining the structure reuse entry - the latest access of a
+ * block, time 0 for an empty slot of the table. */
+struct reuse_entry {
+    unsigned long block;
+    unsigned time;
+};
+
+/* Definining the structure reuse stack - the LRU stack of one set.
+ * table, table_size, block_count - Open addressing table of blocks.
+ * fenwick, capacity - Fenwick tree over timestamps 1..capacity, with
+ *                     a 1 at the latest access of every block.
+ * now - Timestamp of the last access, the timestamps are renumbered
+ *       when it reaches capacity.
+ * */
+struct reuse_stack {
+    struct reuse_entry *table;
+    unsigned table_size;
+    unsigned block_count;
+    unsigned *fenwick;
+    unsigned capacity;
+    unsigned now;
+};
+
+/* Definining the structure mrc_level - the stacks of all sets of a
+ * cache with 2^set_bits sets, and their combined distances.
+ * histogram - Accesses by stack distance, in bins of 2^bin_shift
+ *             distances, weighted by 1/R.
+ * sampled_weight - Weight of all recorded accesses, cold ones too.
+ * */
+struct mrc_level {
+    int set_bits;
+    struct reuse_stack *stacks;
+    double *histogram;
+    unsigned long histogram_size;
+    int bin_shift;
+    double sampled_weight;
+};
+
+/* Definining the structure sample - a tracked block in the max-heap
+ * of sampling hashes. */
+struct sample {
+    unsigned long hash;
+    unsigned long block;
+};
+
+/* Definining the structure mrc - curves for 1, 2, ... 2^max_set_bits
+ * sets of blocks of 2^block_bits bytes.
+ * threshold - Blocks hashing below it are sampled.
+ * seed - Salt of the sampling hash.
+ * sample_max - Most blocks to track, 0 for no limit.
+ * heap, sample_count - Tracked blocks when there is a limit.
+ * */
+struct mrc {
+    int block_bits;
+    int max_set_bits;
+    unsigned long access_count;
+    unsigned long threshold;
+    unsigned long seed;
+    unsigned long sample_max;
+    struct sample *heap;
+    unsigned long sample_count;
+    struct mrc_level levels[MRC_MAX_SET_BITS + 1];
+};
+
+/* Sets up the stacks, returns 0 on success and -1 on error. A rate
+ * of 1 and no sample limit give the exact curves. */
+int mrc_init(struct mrc *mrc, int max_set_bits, int block_bits,
+             double rate, unsigned long sample_max, unsigned long seed);
+
+/* Records one access, returns -1 if memory ran out */
+int mrc_access(struct mrc *mrc, unsigned long address);
+
+/* Returns 1 if the trace had accesses but none of their blocks were
+ * sampled, so there is nothing to estimate the curves from */
+int mrc_sample_empty(struct mrc *mrc);
+
+/* Estimated miss ratio of 2^set_bits sets of 'ways' lines */
+double mrc_miss_ratio(struct mrc *mrc, int set_bits, unsigned long ways);
+
+/* Writes the exact curves as CSV: one row per set count and
+ * associativity at which the miss ratio changes */
+void mrc_write_csv(struct mrc *mrc, FILE *out);
+
+/* Writes sampled curves as CSV at power of 2 associativities, with
+ * the mean and standard deviation over runs with different seeds */
+void mrc_write_sampled_csv(struct mrc *runs, int run_count, FILE *out);
+
+/* Releases all memory */
+void mrc_free(struct mrc *mrc);
+
+#endif /* CSIM_MRC_H */
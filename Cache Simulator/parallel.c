@@ -0,0 +1,238 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Parallel simulation of one cache geometry. The
+ * calling thread decodes trace batches and appends
+ * each access to the buffer of the shard that owns
+ * its set. Every shard has a small ring of buffers
+ * and a worker thread that drains it, so decoding
+ * and simulation overlap and a lock is only taken
+ * once per buffer. The workers count into their own
+ * shard, and the counts are added up at the end.
+ ********************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "parallel.h"
+
+/* Accesses per buffer, and buffers in flight per shard */
+#define SHARD_BATCH 4096
+#define SHARD_QUEUE 4
+
+/* Definining the structure shard_buffer - accesses for one shard.
+ * write, size - Set for a store of 'size' bytes.
+ * */
+struct shard_buffer {
+    int count;
+    unsigned long address[SHARD_BATCH];
+    unsigned size[SHARD_BATCH];
+    char write[SHARD_BATCH];
+};
+
+/* Definining the structure shard - a worker and its queue.
+ * ring, head, queued - Buffers tail..tail+queued-1 wait for the
+ *                      worker, the reader fills ring[head].
+ * done - Set by the reader after the last buffer.
+ * */
+struct shard {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    struct shard_buffer ring[SHARD_QUEUE];
+    int head;
+    int tail;
+    int queued;
+    int done;
+    struct cache *const *caches;
+    int cache_count;
+    struct cache_counts counts[PARALLEL_MAX_CACHES];
+};
+
+/* Function - simulate_buffer
+ * Running the accesses of a buffer against every cache.
+ * */
+static void simulate_buffer(struct shard *shard, struct shard_buffer *buffer){
+    struct cache *cache;
+    int i;
+    int c;
+
+    for (i = 0; i < buffer->count; i++) {
+        for (c = 0; c < shard->cache_count; c++) {
+            cache = shard->caches[c];
+            cache_reference(cache, buffer->address[i] >> cache->block_bits,
+                            buffer->write[i], buffer->size[i],
+                            &shard->counts[c]);
+        }
+    }
+}
+
+/* Function - worker
+ * Thread body, draining the shard's ring until the reader
+ * is done and the ring is empty.
+ * */
+static void *worker(void *arg){
+    struct shard *shard = arg;
+    struct shard_buffer *buffer;
+
+    for (;;) {
+        pthread_mutex_lock(&shard->lock);
+        while (shard->queued == 0 && !shard->done)
+            pthread_cond_wait(&shard->not_empty, &shard->lock);
+        if (shard->queued == 0) {
+            pthread_mutex_unlock(&shard->lock);
+            return NULL;
+        }
+        buffer = &shard->ring[shard->tail];
+        pthread_mutex_unlock(&shard->lock);
+
+        simulate_buffer(shard, buffer);
+
+        pthread_mutex_lock(&shard->lock);
+        shard->tail = (shard->tail + 1) % SHARD_QUEUE;
+        shard->queued--;
+        pthread_cond_signal(&shard->not_full);
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+/* Function - publish
+ * Handing the buffer being filled to the worker and waiting
+ * until the next one is free.
+ * */
+static void publish(struct shard *shard){
+    pthread_mutex_lock(&shard->lock);
+    shard->head = (shard->head + 1) % SHARD_QUEUE;
+    shard->queued++;
+    pthread_cond_signal(&shard->not_empty);
+    while (shard->queued == SHARD_QUEUE)
+        pthread_cond_wait(&shard->not_full, &shard->lock);
+    shard->ring[shard->head].count = 0;
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/* Function - route
+ * Appending an access to the buffer of the shard that owns
+ * its set.
+ * */
+static inline void route(struct shard *shards, int shard_count,
+                         struct cache *cache, unsigned long address,
+                         int write, unsigned size){
+    unsigned long set_number = (address >> cache->block_bits) &
+                               ((1UL << cache->set_bits) - 1);
+    struct shard *shard =
+        shards + ((set_number * shard_count) >> cache->set_bits);
+    struct shard_buffer *buffer = &shard->ring[shard->head];
+
+    buffer->address[buffer->count] = address;
+    buffer->write[buffer->count] = write;
+    buffer->size[buffer->count++] = size;
+    if (buffer->count == SHARD_BATCH)
+        publish(shard);
+}
+
+/* Function - parallel_simulate
+ * Decoding the trace on the calling thread and simulating it
+ * on 'thread_count' workers (at most one per set).
+ * ---------------------------------------------------
+ * Input parameters:
+ * Open trace, pointers to caches of one geometry, their
+ * number and the number of threads.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, -1 if the threads couldn't be set up.
+ * --------------------------------------------------
+ * */
+int parallel_simulate(struct trace_reader *trace,
+                      struct cache *const *caches, int cache_count,
+                      int thread_count){
+    struct trace_access batch[TRACE_BATCH];
+    struct shard *shards;
+    int count;
+    int k;
+    int c;
+    int started = 0;
+
+    if (cache_count > PARALLEL_MAX_CACHES)
+        return -1;
+    if (thread_count > PARALLEL_MAX_THREADS)
+        thread_count = PARALLEL_MAX_THREADS;
+    if ((unsigned long)thread_count > (1UL << caches[0]->set_bits))
+        thread_count = 1 << caches[0]->set_bits;
+
+    shards = calloc(thread_count, sizeof(struct shard));
+    if (shards == NULL)
+        return -1;
+    for (k = 0; k < thread_count; k++) {
+        shards[k].caches = caches;
+        shards[k].cache_count = cache_count;
+        pthread_mutex_init(&shards[k].lock, NULL);
+        pthread_cond_init(&shards[k].not_empty, NULL);
+        pthread_cond_init(&shards[k].not_full, NULL);
+    }
+    for (k = 0; k < thread_count; k++) {
+        if (pthread_create(&shards[k].thread, NULL, worker, shards+k) != 0)
+            break;
+        started++;
+    }
+
+    if (started == thread_count) {
+        while ((count = trace_next_batch(trace, batch, TRACE_BATCH)) > 0) {
+            for (k = 0; k < count; k++) {
+                switch(batch[k].op) {
+                    case 'M':
+                        // A load followed by a store.
+                        route(shards, thread_count, caches[0],
+                              batch[k].address, 0, 0);
+                        route(shards, thread_count, caches[0],
+                              batch[k].address, 1,
+                              batch[k].size);
+                        break;
+                    case 'L':
+                        route(shards, thread_count, caches[0],
+                              batch[k].address, 0, 0);
+                        break;
+                    case 'S':
+                        route(shards, thread_count, caches[0],
+                              batch[k].address, 1,
+                              batch[k].size);
+                        break;
+                }
+            }
+        }
+        // Handing over the partly filled buffers.
+        for (k = 0; k < thread_count; k++) {
+            if (shards[k].ring[shards[k].head].count > 0)
+                publish(shards + k);
+        }
+    }
+
+    for (k = 0; k < started; k++) {
+        pthread_mutex_lock(&shards[k].lock);
+        shards[k].done = 1;
+        pthread_cond_signal(&shards[k].not_empty);
+        pthread_mutex_unlock(&shards[k].lock);
+        pthread_join(shards[k].thread, NULL);
+        for (c = 0; c < cache_count; c++) {
+            struct cache_counts *total = &caches[c]->counts;
+            struct cache_counts *part = &shards[k].counts[c];
+            total->hit_count += part->hit_count;
+            total->miss_count += part->miss_count;
+            total->eviction_count += part->eviction_count;
+            total->dirty_eviction_count += part->dirty_eviction_count;
+            total->write_bytes += part->write_bytes;
+            total->prefetch_count += part->prefetch_count;
+            total->prefetch_hit_count += part->prefetch_hit_count;
+            total->prefetch_unused_count += part->prefetch_unused_count;
+        }
+    }
+    for (k = 0; k < thread_count; k++) {
+        pthread_mutex_destroy(&shards[k].lock);
+        pthread_cond_destroy(&shards[k].not_empty);
+        pthread_cond_destroy(&shards[k].not_full);
+    }
+    free(shards);
+    return started == thread_count ? 0 : -1;
+}
@@ -0,0 +1,29 @@
+/*
+ * parallel.h - Set-partitioned parallel simulation
+ *
+ * Sets never interact, so each worker thread owns a contiguous range
+ * of sets and simulates only the accesses that map there. The calling
+ * thread decodes the trace and routes the accesses. Every set sees
+ * its accesses in trace order, so the counts are the same as those of
+ * a serial run.
+ */
+
+#ifndef CSIM_PARALLEL_H
+#define CSIM_PARALLEL_H
+
+#include "cache.h"
+#include "trace.h"
+
+/* Most threads, and most caches simulated side by side */
+#define PARALLEL_MAX_THREADS 64
+#define PARALLEL_MAX_CACHES 16
+
+/* Runs the data accesses of a trace against caches of the same
+ * geometry on up to 'thread_count' threads and adds the results to
+ * their counts. Returns 0 on success and -1 if the
+ * threads couldn't be set up. */
+int parallel_simulate(struct trace_reader *trace,
+                      struct cache *const *caches, int cache_count,
+                      int thread_count);
+
+#endif /* CSIM_PARALLEL_H */
@@ -0,0 +1,250 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Hardware prefetcher models for the cache simulator.
+ * Each demand access goes to the cache first, then
+ * trains the prefetcher, which fills the blocks it
+ * predicts through cache_prefetch. The arrival time
+ * of recent prefetches is kept in a small hash table,
+ * so that first hits that come too early can be told
+ * apart from useful ones.
+ ********************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "prefetch.h"
+
+/* Stream prefetcher: misses at most this many blocks apart train
+ * the same stream, which runs ahead once it has gone the same way
+ * STREAM_CONFIRM times */
+#define STREAM_WINDOW 16
+#define STREAM_CONFIRM 2
+
+/* Highest stride confidence, one repeat is enough to prefetch */
+#define STRIDE_CONFIDENCE_MAX 3
+
+/* Function - hash_slot
+ * Slot of a key in a table of 'size' entries, a power of 2.
+ * */
+static inline unsigned long hash_slot(unsigned long key, unsigned long size){
+    return ((key * 0x9e3779b97f4a7c15UL) >> 32) & (size-1);
+}
+
+/* Function - prefetch_find
+ * Looking a prefetcher up by name.
+ * ---------------------------------------------------
+ * Return value:
+ * PREFETCH_ value, or -1 for an unknown name.
+ * --------------------------------------------------
+ * */
+int prefetch_find(const char *name){
+    if (strcmp(name, "none") == 0)
+        return PREFETCH_NONE;
+    if (strcmp(name, "next") == 0)
+        return PREFETCH_NEXT;
+    if (strcmp(name, "stride") == 0)
+        return PREFETCH_STRIDE;
+    if (strcmp(name, "stream") == 0)
+        return PREFETCH_STREAM;
+    return -1;
+}
+
+/* Function - prefetcher_init
+ * Setting up a prefetcher with empty tables.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Prefetcher, PREFETCH_ kind, blocks prefetched per trigger
+ * and accesses a prefetch takes to arrive.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if the memory couldn't be allocated.
+ * --------------------------------------------------
+ * */
+int prefetcher_init(struct prefetcher *prefetcher, int kind, int degree,
+                    int latency){
+    memset(prefetcher, 0, sizeof(struct prefetcher));
+    prefetcher->kind = kind;
+    prefetcher->degree = degree;
+    prefetcher->latency = latency;
+    prefetcher->strides = calloc(PREFETCH_STRIDE_ENTRIES,
+                                 sizeof(struct stride_entry));
+    prefetcher->in_flight = calloc(PREFETCH_IN_FLIGHT,
+                                   sizeof(struct in_flight));
+    if (prefetcher->strides == NULL || prefetcher->in_flight == NULL) {
+        prefetcher_free(prefetcher);
+        return -1;
+    }
+    return 0;
+}
+
+/* Function - prefetcher_free
+ * Releasing the tables of a prefetcher.
+ * */
+void prefetcher_free(struct prefetcher *prefetcher){
+    free(prefetcher->strides);
+    free(prefetcher->in_flight);
+    prefetcher->strides = NULL;
+    prefetcher->in_flight = NULL;
+}
+
+/* Function - issue
+ * Prefetching a block number, and remembering when it arrives
+ * if it wasn't cached yet.
+ * */
+static void issue(struct prefetcher *prefetcher, struct cache *cache,
+                  unsigned long block){
+    struct in_flight *entry;
+
+    if (!cache_prefetch(cache, block, &cache->counts))
+        return;
+    entry = prefetcher->in_flight + hash_slot(block, PREFETCH_IN_FLIGHT);
+    entry->block = block;
+    entry->ready = prefetcher->now + prefetcher->latency;
+}
+
+/* Function - train_stride
+ * Updating the table entry of an instruction and prefetching
+ * along its stride once the stride has repeated. Accesses to
+ * the address the instruction last used (the two halves of
+ * 'M') leave the entry alone.
+ * */
+static void train_stride(struct prefetcher *prefetcher, struct cache *cache,
+                         unsigned long pc, unsigned long address){
+    struct stride_entry *entry =
+        prefetcher->strides + hash_slot(pc, PREFETCH_STRIDE_ENTRIES);
+    unsigned long block = address >> cache->block_bits;
+    unsigned long next;
+    long stride;
+    int k;
+
+    if (entry->pc != pc || entry->address == 0) {
+        entry->pc = pc;
+        entry->address = address;
+        entry->stride = 0;
+        entry->confidence = 0;
+        return;
+    }
+    stride = (long)(address - entry->address);
+    if (stride == 0)
+        return;
+    if (stride == entry->stride) {
+        if (entry->confidence < STRIDE_CONFIDENCE_MAX)
+            entry->confidence++;
+    } else {
+        entry->stride = stride;
+        entry->confidence = 0;
+    }
+    entry->address = address;
+    if (entry->confidence == 0)
+        return;
+
+    // Strides shorter than a block reach the same block repeatedly.
+    for (k = 1; k <= prefetcher->degree; k++) {
+        next = (address + k*stride) >> cache->block_bits;
+        if (next != block)
+            issue(prefetcher, cache, next);
+        block = next;
+    }
+}
+
+/* Function - train_stream
+ * Matching a miss against the tracked regions. A miss close to
+ * a stream moves it along and, once the stream has gone the
+ * same way often enough, prefetches ahead of it. Any other
+ * miss starts a stream in place of the least recently used.
+ * */
+static void train_stream(struct prefetcher *prefetcher, struct cache *cache,
+                         unsigned long block){
+    struct stream_entry *stream;
+    struct stream_entry *oldest = prefetcher->streams;
+    unsigned long distance;
+    int direction;
+    int k;
+
+    for (k = 0; k < PREFETCH_STREAMS; k++) {
+        stream = prefetcher->streams + k;
+        if (stream->last_use < oldest->last_use)
+            oldest = stream;
+        if (stream->last_use == 0)
+            continue;
+        distance = block > stream->block ? block - stream->block :
+                                           stream->block - block;
+        if (distance != 0 && distance <= STREAM_WINDOW)
+            break;
+    }
+    if (k == PREFETCH_STREAMS) {
+        oldest->block = block;
+        oldest->direction = 0;
+        oldest->confidence = 0;
+        oldest->last_use = prefetcher->now;
+        return;
+    }
+
+    direction = block > stream->block ? 1 : -1;
+    if (direction == stream->direction) {
+        if (stream->confidence < STREAM_CONFIRM)
+            stream->confidence++;
+    } else {
+        stream->direction = direction;
+        stream->confidence = 1;
+    }
+    stream->block = block;
+    stream->last_use = prefetcher->now;
+    if (stream->confidence < STREAM_CONFIRM)
+        return;
+    for (k = 1; k <= prefetcher->degree; k++)
+        issue(prefetcher, cache, block + k*direction);
+}
+
+/* Function - prefetcher_access
+ * Running a demand access against the cache, checking
+ * whether a prefetched block it hit had arrived, and training
+ * the prefetcher. The next-line and stream prefetchers only
+ * look at misses and first hits of prefetched blocks, the
+ * way a prefetcher that sits behind the cache would.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Prefetcher, its cache, address of the instruction, data
+ * address, 1 for a store and the number of bytes stored.
+ * --------------------------------------------------
+ * Return value:
+ * 1 on a hit, 2 on the first hit of a prefetched block and
+ * 0 on a miss.
+ * --------------------------------------------------
+ * */
+int prefetcher_access(struct prefetcher *prefetcher, struct cache *cache,
+                      unsigned long pc, unsigned long address, int write,
+                      unsigned size){
+    unsigned long block = address >> cache->block_bits;
+    struct in_flight *entry;
+    int result;
+    int k;
+
+    prefetcher->now++;
+    result = cache_reference(cache, block, write, size, &cache->counts);
+    if (result == 2) {
+        entry = prefetcher->in_flight +
+                hash_slot(block, PREFETCH_IN_FLIGHT);
+        if (entry->block == block && prefetcher->now < entry->ready)
+            prefetcher->late_count++;
+    }
+
+    switch(prefetcher->kind) {
+        case PREFETCH_NEXT:
+            if (result != 1) {
+                for (k = 1; k <= prefetcher->degree; k++)
+                    issue(prefetcher, cache, block + k);
+            }
+            break;
+        case PREFETCH_STRIDE:
+            train_stride(prefetcher, cache, pc, address);
+            break;
+        case PREFETCH_STREAM:
+            if (result != 1)
+                train_stream(prefetcher, cache, block);
+            break;
+    }
+    return result;
+}
@@ -0,0 +1,105 @@
+/*
+ * prefetch.h - Hardware prefetcher models in front of struct cache
+ *
+ * A prefetcher sees every demand access of a cache and brings the
+ * blocks it predicts in as prefetches (see cache_prefetch):
+ * next   - The next 'degree' blocks after a miss, or after the first
+ *          hit of a prefetched block (tagged next-line).
+ * stride - A table of the last address and stride of each
+ *          instruction, taken from the 'I' record before the access.
+ *          Once a stride repeats, the next 'degree' strides ahead are
+ *          prefetched. Traces without 'I' records train one entry.
+ * stream - Misses close to each other in a few tracked regions
+ *          train a stream and its direction, and a confirmed stream
+ *          runs 'degree' blocks ahead.
+ *
+ * A prefetch takes 'latency' demand accesses to arrive. The first hit
+ * of a prefetched block is useful if it came after that and late if
+ * it came before, and a prefetched block evicted without a hit was
+ * useless.
+ */
+
+#ifndef CSIM_PREFETCH_H
+#define CSIM_PREFETCH_H
+
+#include "cache.h"
+
+#define PREFETCH_NONE   0
+#define PREFETCH_NEXT   1
+#define PREFETCH_STRIDE 2
+#define PREFETCH_STREAM 3
+
+/* Table sizes: instructions tracked by the stride prefetcher,
+ * regions tracked by the stream prefetcher and prefetches whose
+ * arrival time is remembered */
+#define PREFETCH_STRIDE_ENTRIES 256
+#define PREFETCH_STREAMS 16
+#define PREFETCH_IN_FLIGHT 4096
+
+/* Definining the structure stride entry - the last access of one
+ * instruction.
+ * confidence - Times the stride repeated in a row, saturating at 3.
+ * */
+struct stride_entry {
+    unsigned long pc;
+    unsigned long address;
+    long stride;
+    int confidence;
+};
+
+/* Definining the structure stream entry - one tracked region.
+ * block - Last block number that trained the stream.
+ * direction - +1 or -1 once known, 0 before.
+ * confidence - Misses in a row that went in that direction.
+ * last_use - Access time, for replacing the oldest stream.
+ * */
+struct stream_entry {
+    unsigned long block;
+    int direction;
+    int confidence;
+    unsigned long last_use;
+};
+
+/* Definining the structure in flight - a prefetched block and the
+ * access time it arrives at.
+ * */
+struct in_flight {
+    unsigned long block;
+    unsigned long ready;
+};
+
+/* Definining the structure prefetcher.
+ * now - Demand accesses seen so far, the clock of 'latency'.
+ * late_count - First hits of prefetched blocks that came too early.
+ * */
+struct prefetcher {
+    int kind;
+    int degree;
+    int latency;
+    unsigned long now;
+    struct stride_entry *strides;
+    struct stream_entry streams[PREFETCH_STREAMS];
+    struct in_flight *in_flight;
+    unsigned long late_count;
+};
+
+/* Looks a prefetcher up by name, returns PREFETCH_NONE for "none"
+ * and -1 for an unknown name */
+int prefetch_find(const char *name);
+
+/* Sets up an untrained prefetcher, returns 0 on success and -1 on
+ * error */
+int prefetcher_init(struct prefetcher *prefetcher, int kind, int degree,
+                    int latency);
+
+/* Releases the tables of a prefetcher */
+void prefetcher_free(struct prefetcher *prefetcher);
+
+/* cache_reference on the cache's own counts, followed by the
+ * prefetches the access triggers. 'pc' is the address of the
+ * instruction making the access. Returns what cache_reference did. */
+int prefetcher_access(struct prefetcher *prefetcher, struct cache *cache,
+                      unsigned long pc, unsigned long address, int write,
+                      unsigned size);
+
+#endif /* CSIM_PREFETCH_H */
@@ -0,0 +1,67 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Memory access recorder for kernels built with the
+ * LOAD and STORE macros of recorder.h. Accesses go to
+ * a buffer that doubles when full, in the form the
+ * trace reader decodes lines into, so they can be
+ * simulated like the lines of a trace file.
+ ********************************************************/
+
+#include <stdlib.h>
+#include "recorder.h"
+
+struct recorder *recorder_active = NULL;
+
+/* Function - recorder_init
+ * Setting up an empty recorder. The buffer is allocated by
+ * the first access.
+ * */
+void recorder_init(struct recorder *recorder){
+    recorder->accesses = NULL;
+    recorder->count = 0;
+    recorder->capacity = 0;
+    recorder->failed = 0;
+}
+
+/* Function - recorder_free
+ * Releasing the buffer of a recorder, and making sure the
+ * kernels don't write to it any more.
+ * */
+void recorder_free(struct recorder *recorder){
+    if (recorder_active == recorder)
+        recorder_active = NULL;
+    free(recorder->accesses);
+    recorder_init(recorder);
+}
+
+/* Function - recorder_reset
+ * Dropping the recorded accesses for the next recording.
+ * */
+void recorder_reset(struct recorder *recorder){
+    recorder->count = 0;
+    recorder->failed = 0;
+}
+
+/* Function - recorder_grow
+ * Doubling the buffer, which starts out with 64K accesses.
+ * ---------------------------------------------------
+ * Return value:
+ * 0 on success and -1 if the memory couldn't be allocated,
+ * in which case the buffer is left as it was.
+ * --------------------------------------------------
+ * */
+int recorder_grow(struct recorder *recorder){
+    unsigned long capacity = recorder->capacity ?
+                             2*recorder->capacity : 1UL << 16;
+    struct trace_access *accesses =
+        realloc(recorder->accesses, capacity*sizeof(struct trace_access));
+
+    if (accesses == NULL)
+        return -1;
+    recorder->accesses = accesses;
+    recorder->capacity = capacity;
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * recorder.h - In-process memory access recorder for kernels
+ *
+ * A kernel reads and writes the memory it wants simulated through
+ * LOAD(x) and STORE(x, v):
+ *
+ *     t0 = LOAD(A[i][j]);
+ *     STORE(B[j][i], t0);
+ *
+ * Built with -DCSIM_RECORD, these append an access with the address
+ * and size of x to the active recorder, if there is one. Otherwise
+ * they are plain reads and writes, so the kernel can still be traced
+ * with valgrind. The recorded accesses are in the form of decoded
+ * trace lines, so csim_access_batch (see libcsim.h) simulates them on
+ * any number of caches afterwards, without a trace file. Only the
+ * accesses written through the macros are recorded, so locals the
+ * compiler spills to the stack are not.
+ */
+
+#ifndef CSIM_RECORDER_H
+#define CSIM_RECORDER_H
+
+#include "trace.h"
+
+/* Definining the structure recorder - a growing buffer of accesses
+ * in trace order.
+ * failed - Set if the buffer couldn't grow, so accesses are missing.
+ * */
+struct recorder {
+    struct trace_access *accesses;
+    unsigned long count;
+    unsigned long capacity;
+    int failed;
+};
+
+/* Recorder that LOAD and STORE append to, NULL when not recording */
+extern struct recorder *recorder_active;
+
+/* Sets up an empty recorder */
+void recorder_init(struct recorder *recorder);
+
+/* Releases the accesses */
+void recorder_free(struct recorder *recorder);
+
+/* Drops the accesses recorded so far, keeping the buffer */
+void recorder_reset(struct recorder *recorder);
+
+/* Makes room for more accesses, returns 0 on success and -1 if the
+ * memory couldn't be allocated */
+int recorder_grow(struct recorder *recorder);
+
+/* Function - recorder_log
+ * Appending one access to the active recorder. Inline, as the
+ * kernel calls it for every access.
+ * */
+static inline void recorder_log(char op, const void *address,
+                                unsigned size){
+    struct recorder *recorder = recorder_active;
+    struct trace_access *access;
+
+    if (recorder == NULL)
+        return;
+    if (recorder->count == recorder->capacity &&
+        recorder_grow(recorder) < 0) {
+        recorder->failed = 1;
+        return;
+    }
+    access = recorder->accesses + recorder->count++;
+    access->address = (unsigned long)address;
+    access->size = size;
+    access->op = op;
+}
+
+#ifdef CSIM_RECORD
+#define LOAD(x) (recorder_log('L', &(x), sizeof(x)), (x))
+// The value is worked out first, so loads in it are recorded first.
+#define STORE(x, v) ({ __typeof__(x) stored_ = (v); \
+                       recorder_log('S', &(x), sizeof(x)); \
+                       (x) = stored_; })
+#else
+#define LOAD(x) (x)
+#define STORE(x, v) ((x) = (v))
+#endif
+
+#endif /* CSIM_RECORDER_H */
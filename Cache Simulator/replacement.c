@@ -0,0 +1,224 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Replacement policies for the cache simulator. LRU
+ * and FIFO evict the end of the recency list kept by
+ * cache.c. The others keep a few bits per line in
+ * the cache's 'state' array: the tree of tree-PLRU,
+ * the re-reference prediction value of SRRIP/BRRIP or
+ * the use count of LFU. Victims are only picked from
+ * full sets.
+ ********************************************************/
+
+#include <limits.h>
+#include <string.h>
+#include "cache.h"
+
+/* Largest re-reference prediction value, 2 bits per line */
+#define RRPV_MAX 3
+
+/* BRRIP inserts with a long instead of a distant re-reference
+ * prediction once every BRRIP_LONG fills */
+#define BRRIP_LONG 32
+
+/* Function - next_random
+ * xorshift64 step on the set's random state, so runs are
+ * repeatable however the sets are spread over threads.
+ * */
+static unsigned long next_random(struct cache_set *set){
+    unsigned long x = set->random_state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    set->random_state = x;
+    return x;
+}
+
+/* Function - set_state
+ * The policy state of the lines of a set.
+ * */
+static inline unsigned *set_state(struct cache *cache,
+                                  unsigned long set_number){
+    return cache->state + set_number*cache->number_of_lines;
+}
+
+/* Function - lru_victim
+ * The end of the recency list. Used by FIFO too, whose list
+ * is in fill order.
+ * */
+static int lru_victim(struct cache *cache, unsigned long set_number){
+    return cache->sets[set_number].lru;
+}
+
+/* Function - random_victim
+ * Any line of the set, uniformly.
+ * */
+static int random_victim(struct cache *cache, unsigned long set_number){
+    return next_random(cache->sets + set_number) % cache->number_of_lines;
+}
+
+/* Function - plru_touch
+ * Tree-PLRU keeps E-1 bits in a binary tree over the lines, with
+ * node n (the root is 1, the children of n are 2n and 2n+1) in the
+ * state of line n-1. A bit says which half holds the next victim,
+ * so touching a line points all bits on its path away from it.
+ * */
+static void plru_touch(struct cache *cache, unsigned long set_number,
+                       int j){
+    unsigned *state = set_state(cache, set_number);
+    int n = j + cache->number_of_lines;
+
+    while (n > 1) {
+        // A left child (even n) sends the victim to the right.
+        state[n/2 - 1] = !(n & 1);
+        n /= 2;
+    }
+}
+
+/* Function - plru_victim
+ * Following the tree bits from the root down to a leaf.
+ * */
+static int plru_victim(struct cache *cache, unsigned long set_number){
+    unsigned *state = set_state(cache, set_number);
+    int n = 1;
+
+    while (n < cache->number_of_lines)
+        n = 2*n + state[n-1];
+    return n - cache->number_of_lines;
+}
+
+/* Function - rrip_hit
+ * A hit predicts a near re-reference.
+ * */
+static void rrip_hit(struct cache *cache, unsigned long set_number, int j){
+    set_state(cache, set_number)[j] = 0;
+}
+
+/* Function - srrip_fill
+ * SRRIP inserts with a long re-reference prediction, so new
+ * blocks have to hit once before they outlive old ones.
+ * */
+static void srrip_fill(struct cache *cache, unsigned long set_number,
+                       int j){
+    set_state(cache, set_number)[j] = RRPV_MAX - 1;
+}
+
+/* Function - brrip_fill
+ * BRRIP mostly inserts with a distant prediction, which keeps
+ * scans from flushing the working set.
+ * */
+static void brrip_fill(struct cache *cache, unsigned long set_number,
+                       int j){
+    set_state(cache, set_number)[j] =
+        (next_random(cache->sets + set_number) % BRRIP_LONG == 0) ?
+        RRPV_MAX - 1 : RRPV_MAX;
+}
+
+/* Function - rrip_victim
+ * The first line with a distant prediction. If there is none,
+ * all lines age by the amount that gives the oldest one a
+ * distant prediction, which is the same as aging them step by
+ * step until one gets there.
+ * */
+static int rrip_victim(struct cache *cache, unsigned long set_number){
+    unsigned *state = set_state(cache, set_number);
+    unsigned oldest = 0;
+    int victim = 0;
+    int j;
+
+    for (j = 0; j < cache->number_of_lines; j++) {
+        if (state[j] > oldest) {
+            oldest = state[j];
+            victim = j;
+            if (oldest == RRPV_MAX)
+                return victim;
+        }
+    }
+    for (j = 0; j < cache->number_of_lines; j++)
+        state[j] += RRPV_MAX - oldest;
+    return victim;
+}
+
+/* Function - lfu_hit
+ * Counting a use, saturating.
+ * */
+static void lfu_hit(struct cache *cache, unsigned long set_number, int j){
+    unsigned *state = set_state(cache, set_number);
+
+    if (state[j] != UINT_MAX)
+        state[j]++;
+}
+
+/* Function - lfu_fill
+ * A new block has been used once.
+ * */
+static void lfu_fill(struct cache *cache, unsigned long set_number, int j){
+    set_state(cache, set_number)[j] = 1;
+}
+
+/* Function - lfu_victim
+ * The line with the fewest uses. Walking from the LRU end and
+ * only taking strictly smaller counts breaks ties by recency.
+ * */
+static int lfu_victim(struct cache *cache, unsigned long set_number){
+    unsigned *state = set_state(cache, set_number);
+    struct cache_link *links =
+        cache->links + set_number*cache->number_of_lines;
+    int victim = cache->sets[set_number].lru;
+    int j;
+
+    for (j = links[victim].prev; j >= 0; j = links[j].prev) {
+        if (state[j] < state[victim])
+            victim = j;
+    }
+    return victim;
+}
+
+static const struct replacement_policy lru =
+    { "lru", 0, 0, NULL, NULL, lru_victim };
+static const struct replacement_policy fifo =
+    { "fifo", 1, 0, NULL, NULL, lru_victim };
+static const struct replacement_policy random_policy =
+    { "random", 0, 0, NULL, NULL, random_victim };
+static const struct replacement_policy plru =
+    { "plru", 0, 1, plru_touch, plru_touch, plru_victim };
+static const struct replacement_policy srrip =
+    { "srrip", 0, 0, rrip_hit, srrip_fill, rrip_victim };
+static const struct replacement_policy brrip =
+    { "brrip", 0, 0, rrip_hit, brrip_fill, rrip_victim };
+static const struct replacement_policy lfu =
+    { "lfu", 0, 0, lfu_hit, lfu_fill, lfu_victim };
+
+const struct replacement_policy *const replacement_policies[] = {
+    &lru, &fifo, &random_policy, &plru, &srrip, &brrip, &lfu, NULL
+};
+
+/* Function - replacement_find
+ * Looking a policy up by name.
+ * ---------------------------------------------------
+ * Return value:
+ * The policy, or NULL for an unknown name.
+ * --------------------------------------------------
+ * */
+const struct replacement_policy *replacement_find(const char *name){
+    int k;
+
+    for (k = 0; replacement_policies[k] != NULL; k++) {
+        if (strcmp(replacement_policies[k]->name, name) == 0)
+            return replacement_policies[k];
+    }
+    return NULL;
+}
+
+/* Function - replacement_supports
+ * Checking that a policy can manage sets of E lines.
+ * */
+int replacement_supports(const struct replacement_policy *policy,
+                         int number_of_lines){
+    if (policy->power_of_two)
+        return (number_of_lines & (number_of_lines-1)) == 0;
+    return 1;
+}
@@ -0,0 +1,51 @@
+/*
+ * replacement.h - Replacement policies for struct cache
+ *
+ * Every set keeps its lines in a recency list (see cache.h) with the
+ * invalid lines at the end, so a set with room is always filled from
+ * there. A policy is only asked for a victim once a set is full, and
+ * is told about every hit and fill so it can keep its own state in
+ * the 'state' word of the lines, which is only allocated for
+ * policies with a hit or fill hook.
+ *
+ * Available policies: lru, fifo, random, plru (tree pseudo-LRU, E
+ * must be a power of 2), srrip, brrip (2 bit re-reference interval
+ * prediction) and lfu (ties broken by recency).
+ */
+
+#ifndef CSIM_REPLACEMENT_H
+#define CSIM_REPLACEMENT_H
+
+struct cache;
+
+/* Definining the structure replacement policy.
+ * fill_order - Set if hits leave the recency list alone, so that it
+ *              stays in fill order.
+ * power_of_two - Set if E has to be a power of 2.
+ * hit, fill - Called after line 'j' of a set hit or was filled,
+ *             NULL when the policy has no state to update.
+ * victim - Picks the line to evict from a full set.
+ * Policies only touch the set they are given (random numbers come
+ * from the set too), so different sets can be simulated by
+ * different threads.
+ * */
+struct replacement_policy {
+    const char *name;
+    int fill_order;
+    int power_of_two;
+    void (*hit)(struct cache *cache, unsigned long set_number, int j);
+    void (*fill)(struct cache *cache, unsigned long set_number, int j);
+    int (*victim)(struct cache *cache, unsigned long set_number);
+};
+
+/* All policies, terminated by a NULL entry */
+extern const struct replacement_policy *const replacement_policies[];
+
+/* Looks a policy up by name, returns NULL if there is none */
+const struct replacement_policy *replacement_find(const char *name);
+
+/* Returns 1 if the policy can manage sets of E lines */
+int replacement_supports(const struct replacement_policy *policy,
+                         int number_of_lines);
+
+#endif /* CSIM_REPLACEMENT_H */
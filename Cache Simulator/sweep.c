@@ -0,0 +1,456 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * Sweep mode of the cache simulator. The calling
+ * thread decodes the trace into a small ring of
+ * batches that every worker reads, so the trace is
+ * parsed once however many configurations there are.
+ * A batch slot is reused once all workers are done
+ * with it. Each worker owns every thread_count'th
+ * configuration and runs them grouped by b.
+ ********************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sweep.h"
+
+/* Most values a field of a sweep line can expand to */
+#define SWEEP_MAX_VALUES 64
+
+/* Accesses per batch, and batches in flight */
+#define SWEEP_BATCH 4096
+#define SWEEP_QUEUE 4
+
+/* Definining the structure sweep_batch - decoded data accesses,
+ * with 'M' already split in two.
+ * pending - Workers that haven't finished with the batch yet.
+ * */
+struct sweep_batch {
+    int count;
+    int pending;
+    unsigned long address[SWEEP_BATCH];
+};
+
+/* Definining the structure sweep_ring - the batches shared by the
+ * reader and the workers.
+ * published - Batches handed out so far, batch n is in slot
+ *             n % SWEEP_QUEUE.
+ * finished - Set after the last batch.
+ * */
+struct sweep_ring {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t released;
+    struct sweep_batch slots[SWEEP_QUEUE];
+    unsigned long published;
+    int finished;
+    int worker_count;
+};
+
+/* Definining the structure sweep_worker - a thread and the indices
+ * of its configurations, sorted by b. */
+struct sweep_worker {
+    pthread_t thread;
+    struct sweep_ring *ring;
+    struct cache *caches;
+    int *configs;
+    int config_count;
+};
+
+/* Function - parse_values
+ * Expanding a field of a sweep line: a number, a comma
+ * separated list or a "lo-hi" range, stepping by 1 or, with
+ * 'doubling', in powers of 2.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Field, where to store the values, and the range step.
+ * --------------------------------------------------
+ * Return value:
+ * Number of values, or -1 if the field is malformed.
+ * --------------------------------------------------
+ * */
+static int parse_values(char *field, int *values, int doubling){
+    char *item;
+    char *end;
+    long lo, hi;
+    int count = 0;
+
+    for (item = strtok(field, ","); item != NULL; item = strtok(NULL, ",")) {
+        lo = strtol(item, &end, 10);
+        hi = lo;
+        if (*end == '-')
+            hi = strtol(end + 1, &end, 10);
+        if (end == item || *end != '\0' || lo < 0 || hi < lo)
+            return -1;
+        for (; lo <= hi; lo = doubling ? (lo ? 2*lo : 1) : lo + 1) {
+            if (count == SWEEP_MAX_VALUES)
+                return -1;
+            values[count++] = lo;
+        }
+    }
+    return count;
+}
+
+/* Function - policy_listed
+ * Checking whether a comma separated list of policies names
+ * a policy.
+ * */
+static int policy_listed(const char *list, const char *name){
+    size_t length = strlen(name);
+
+    for (; list != NULL; list = strchr(list, ',') ? strchr(list, ',') + 1
+                                                  : NULL) {
+        if (strncmp(list, name, length) == 0 &&
+            (list[length] == ',' || list[length] == '\0'))
+            return 1;
+    }
+    return 0;
+}
+
+/* Function - policies_valid
+ * Checking that every name in a policy list is a policy.
+ * */
+static int policies_valid(const char *list){
+    char copy[64];
+    char *name;
+
+    if (strcmp(list, "all") == 0)
+        return 1;
+    strcpy(copy, list);
+    for (name = strtok(copy, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (replacement_find(name) == NULL)
+            return 0;
+    }
+    return 1;
+}
+
+/* Function - add_config
+ * Appending a configuration and setting up its cache.
+ * */
+static int add_config(struct sweep *sweep, int set_bits, int number_of_lines,
+                      int block_bits, const struct replacement_policy *policy){
+    struct cache *caches;
+
+    if (sweep->config_count == sweep->capacity) {
+        sweep->capacity = sweep->capacity ? 2*sweep->capacity : 16;
+        caches = realloc(sweep->caches, sweep->capacity * sizeof(*caches));
+        if (caches == NULL)
+            return -1;
+        sweep->caches = caches;
+    }
+    if (cache_init(&sweep->caches[sweep->config_count], set_bits,
+                   number_of_lines, block_bits, policy) < 0)
+        return -1;
+    sweep->config_count++;
+    return 0;
+}
+
+/* Function - sweep_load
+ * Reading a sweep file and setting up a cache for every
+ * configuration it describes.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Sweep to set up and path of the sweep file.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, -1 on error after printing it to stderr.
+ * --------------------------------------------------
+ * */
+int sweep_load(struct sweep *sweep, const char *path){
+    FILE *file = fopen(path, "r");
+    char line[256];
+    char field[4][64];
+    int set_bits[SWEEP_MAX_VALUES];
+    int lines[SWEEP_MAX_VALUES];
+    int block_bits[SWEEP_MAX_VALUES];
+    int s_count, e_count, b_count;
+    int fields, i, j, k, p;
+    int line_number = 0;
+    const struct replacement_policy *policy;
+
+    memset(sweep, 0, sizeof(*sweep));
+    if (file == NULL) {
+        fprintf(stderr, "%s: can't open sweep file\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        line[strcspn(line, "#\n")] = '\0';
+        fields = sscanf(line, "%63s %63s %63s %63s", field[0], field[1],
+                        field[2], field[3]);
+        if (fields <= 0)
+            continue;
+        if (fields < 3)
+            goto bad_line;
+        if (fields == 3)
+            strcpy(field[3], "lru");
+        s_count = parse_values(field[0], set_bits, 0);
+        e_count = parse_values(field[1], lines, 1);
+        b_count = parse_values(field[2], block_bits, 0);
+        if (s_count < 0 || e_count < 0 || b_count < 0 ||
+            !policies_valid(field[3]))
+            goto bad_line;
+
+        // Every combination of the listed values.
+        for (i = 0; i < s_count; i++)
+        for (j = 0; j < e_count; j++)
+        for (k = 0; k < b_count; k++) {
+            if (set_bits[i] > 30 || lines[j] < 1 || block_bits[k] > 30)
+                goto bad_line;
+            for (p = 0; replacement_policies[p] != NULL; p++) {
+                policy = replacement_policies[p];
+                if (strcmp(field[3], "all") != 0) {
+                    if (!policy_listed(field[3], policy->name))
+                        continue;
+                    if (!replacement_supports(policy, lines[j])) {
+                        fprintf(stderr, "%s:%d: %s needs E to be a power "
+                                "of 2\n", path, line_number, policy->name);
+                        goto error;
+                    }
+                } else if (!replacement_supports(policy, lines[j])) {
+                    continue;
+                }
+                if (add_config(sweep, set_bits[i], lines[j], block_bits[k],
+                               policy) < 0) {
+                    fprintf(stderr, "%s:%d: not enough memory\n", path,
+                            line_number);
+                    goto error;
+                }
+            }
+        }
+    }
+    fclose(file);
+    if (sweep->config_count == 0) {
+        fprintf(stderr, "%s: no configurations\n", path);
+        return -1;
+    }
+    return 0;
+
+bad_line:
+    fprintf(stderr, "%s:%d: expected '<s> <E> <b> [<policy>]', each a "
+            "value, list or range\n", path, line_number);
+error:
+    fclose(file);
+    sweep_free(sweep);
+    return -1;
+}
+
+/* Function - run_batch
+ * Running a batch against the configurations of a worker.
+ * Configurations with the same b share one pass over the
+ * batch, with the block number computed once per access.
+ * */
+static void run_batch(struct sweep_worker *worker, struct sweep_batch *batch){
+    int first, last;
+    int block_bits;
+    int i, c;
+    unsigned long block;
+
+    for (first = 0; first < worker->config_count; first = last) {
+        block_bits = worker->caches[worker->configs[first]].block_bits;
+        for (last = first + 1; last < worker->config_count &&
+             worker->caches[worker->configs[last]].block_bits == block_bits;
+             last++)
+            ;
+        for (i = 0; i < batch->count; i++) {
+            block = batch->address[i] >> block_bits;
+            for (c = first; c < last; c++)
+                cache_access_block(&worker->caches[worker->configs[c]],
+                                   block);
+        }
+    }
+}
+
+/* Function - worker_main
+ * Thread body, running every published batch in order.
+ * */
+static void *worker_main(void *arg){
+    struct sweep_worker *worker = arg;
+    struct sweep_ring *ring = worker->ring;
+    struct sweep_batch *batch;
+    unsigned long next;
+
+    for (next = 0; ; next++) {
+        pthread_mutex_lock(&ring->lock);
+        while (ring->published <= next && !ring->finished)
+            pthread_cond_wait(&ring->ready, &ring->lock);
+        if (ring->published <= next) {
+            pthread_mutex_unlock(&ring->lock);
+            return NULL;
+        }
+        batch = &ring->slots[next % SWEEP_QUEUE];
+        pthread_mutex_unlock(&ring->lock);
+
+        run_batch(worker, batch);
+
+        pthread_mutex_lock(&ring->lock);
+        if (--batch->pending == 0)
+            pthread_cond_signal(&ring->released);
+        pthread_mutex_unlock(&ring->lock);
+    }
+}
+
+/* Function - publish
+ * Handing a filled batch to all workers, and waiting until
+ * the next slot is free.
+ * */
+static struct sweep_batch *publish(struct sweep_ring *ring){
+    struct sweep_batch *batch;
+
+    pthread_mutex_lock(&ring->lock);
+    ring->slots[ring->published % SWEEP_QUEUE].pending = ring->worker_count;
+    ring->published++;
+    pthread_cond_broadcast(&ring->ready);
+    batch = &ring->slots[ring->published % SWEEP_QUEUE];
+    while (batch->pending != 0)
+        pthread_cond_wait(&ring->released, &ring->lock);
+    pthread_mutex_unlock(&ring->lock);
+    batch->count = 0;
+    return batch;
+}
+
+static struct cache *sort_caches;
+
+static int by_block_bits(const void *a, const void *b){
+    int x = sort_caches[*(const int *)a].block_bits;
+    int y = sort_caches[*(const int *)b].block_bits;
+
+    return (x > y) - (x < y);
+}
+
+/* Function - sweep_run
+ * Decoding the trace on the calling thread and running it
+ * against all configurations on 'thread_count' workers.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Sweep, open trace and number of threads.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, -1 if the threads couldn't be set up.
+ * --------------------------------------------------
+ * */
+int sweep_run(struct sweep *sweep, struct trace_reader *trace,
+              int thread_count){
+    struct trace_access decoded[TRACE_BATCH];
+    struct sweep_ring *ring;
+    struct sweep_worker *workers;
+    struct sweep_batch *batch;
+    int *configs;
+    int count, repeat;
+    int k, r;
+    int started = 0;
+
+    if (thread_count > sweep->config_count)
+        thread_count = sweep->config_count;
+    if (thread_count < 1)
+        thread_count = 1;
+    ring = calloc(1, sizeof(*ring));
+    workers = calloc(thread_count, sizeof(*workers));
+    configs = malloc(sweep->config_count * sizeof(int));
+    if (ring == NULL || workers == NULL || configs == NULL) {
+        free(ring);
+        free(workers);
+        free(configs);
+        return -1;
+    }
+
+    // Dealing the configurations out round robin, each worker's
+    // share in one block of 'configs', sorted by b.
+    for (k = 0, r = 0; r < thread_count; r++) {
+        workers[r].ring = ring;
+        workers[r].caches = sweep->caches;
+        workers[r].configs = configs + k;
+        for (count = r; count < sweep->config_count; count += thread_count)
+            configs[k++] = count;
+        workers[r].config_count = configs + k - workers[r].configs;
+        sort_caches = sweep->caches;
+        qsort(workers[r].configs, workers[r].config_count, sizeof(int),
+              by_block_bits);
+    }
+
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->ready, NULL);
+    pthread_cond_init(&ring->released, NULL);
+    ring->worker_count = thread_count;
+    for (r = 0; r < thread_count; r++) {
+        if (pthread_create(&workers[r].thread, NULL, worker_main,
+                           workers + r) != 0)
+            break;
+        started++;
+    }
+    // Workers that didn't start never release a batch.
+    ring->worker_count = started;
+
+    batch = &ring->slots[0];
+    while (started == thread_count &&
+           (count = trace_next_batch(trace, decoded, TRACE_BATCH)) > 0) {
+        for (k = 0; k < count; k++) {
+            // Instruction fetches don't touch the data cache, and a
+            // modify is a load followed by a store.
+            if (decoded[k].op == 'I')
+                continue;
+            for (repeat = (decoded[k].op == 'M') ? 2 : 1; repeat > 0;
+                 repeat--) {
+                batch->address[batch->count++] = decoded[k].address;
+                if (batch->count == SWEEP_BATCH)
+                    batch = publish(ring);
+            }
+        }
+    }
+    if (batch->count > 0)
+        publish(ring);
+
+    pthread_mutex_lock(&ring->lock);
+    ring->finished = 1;
+    pthread_cond_broadcast(&ring->ready);
+    pthread_mutex_unlock(&ring->lock);
+    for (r = 0; r < started; r++)
+        pthread_join(workers[r].thread, NULL);
+
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->ready);
+    pthread_cond_destroy(&ring->released);
+    free(ring);
+    free(workers);
+    free(configs);
+    return started == thread_count ? 0 : -1;
+}
+
+/* Function - sweep_report
+ * Printing 's,E,b,policy,hits,misses,evictions,miss_ratio'
+ * rows in the order of the sweep file.
+ * */
+void sweep_report(struct sweep *sweep, FILE *out){
+    unsigned long accesses;
+    int k;
+
+    fprintf(out, "s,E,b,policy,hits,misses,evictions,miss_ratio\n");
+    for (k = 0; k < sweep->config_count; k++) {
+        struct cache *cache = &sweep->caches[k];
+        struct cache_counts *counts = &cache->counts;
+        accesses = counts->hit_count + counts->miss_count;
+        fprintf(out, "%d,%d,%d,%s,%lu,%lu,%lu,%.6f\n", cache->set_bits,
+                cache->number_of_lines, cache->block_bits,
+                cache->policy->name, counts->hit_count, counts->miss_count,
+                counts->eviction_count,
+                accesses ? (double)counts->miss_count / accesses : 0.0);
+    }
+}
+
+/* Function - sweep_free
+ * Releasing the caches of all configurations.
+ * */
+void sweep_free(struct sweep *sweep){
+    int k;
+
+    for (k = 0; k < sweep->config_count; k++)
+        cache_free(&sweep->caches[k]);
+    free(sweep->caches);
+    sweep->caches = NULL;
+    sweep->config_count = 0;
+    sweep->capacity = 0;
+}
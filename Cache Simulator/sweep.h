@@ -0,0 +1,50 @@
+/*
+ * sweep.h - Many cache configurations on one pass over a trace
+ *
+ * A sweep file lists configurations, one line each:
+ *
+ *     <s> <E> <b> [<policy>]
+ *
+ * where every field can also be a comma separated list, and s, E
+ * and b an inclusive range "lo-hi" (E ranges step in powers of 2).
+ * A line stands for every combination of its values, e.g.
+ * "4-8 1,2,4,8 6 lru,plru" is 40 configurations. The policy "all"
+ * means every policy that supports E, and '#' starts a comment.
+ *
+ * The trace is decoded once. Every decoded batch is handed to all
+ * worker threads, and each runs its share of the configurations on
+ * it. Configurations are grouped by b, so a worker splits an address
+ * into block and offset once per group.
+ */
+
+#ifndef CSIM_SWEEP_H
+#define CSIM_SWEEP_H
+
+#include <stdio.h>
+#include "cache.h"
+#include "trace.h"
+
+/* Definining the structure sweep - all configurations of a sweep
+ * file, sorted by b. */
+struct sweep {
+    int config_count;
+    int capacity;
+    struct cache *caches;
+};
+
+/* Reads a sweep file and sets up empty caches, returns 0 on success
+ * and -1 after printing the problem to stderr */
+int sweep_load(struct sweep *sweep, const char *path);
+
+/* Runs the data accesses of a trace against all configurations on
+ * 'thread_count' threads, returns 0 on success and -1 on error */
+int sweep_run(struct sweep *sweep, struct trace_reader *trace,
+              int thread_count);
+
+/* Prints one CSV row per configuration */
+void sweep_report(struct sweep *sweep, FILE *out);
+
+/* Releases the caches */
+void sweep_free(struct sweep *sweep);
+
+#endif /* CSIM_SWEEP_H */
@@ -0,0 +1,29 @@
+#!/bin/sh
+# run_tests.sh - Regression checks for csim
+#
+# Usage: tests/run_tests.sh [<path of csim>]
+# Runs from any directory, exits 1 if a check fails.
+
+csim=${1:-./csim}
+dir=$(dirname "$0")
+failed=0
+
+# check <name> <expected line> <csim arguments...>
+check(){
+    name=$1
+    expected=$2
+    shift 2
+    if "$csim" "$@" | grep -qx "$expected"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name: expected '$expected'"
+        failed=1
+    fi
+}
+
+# A 2MB page must not hit on the entry of a 4KB page in a level with a
+# small s, so the second access to 0x40000000 is the only hit.
+check tlb_mixed_small_s "T                   1            2   66.67%" \
+      -s 4 -E 1 -b 4 -T "$dir/tlb_mixed.cfg" -t "$dir/tlb_mixed.trace"
+
+exit $failed
@@ -0,0 +1,310 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * TLB simulation for the cache simulator. Every TLB
+ * level is a struct cache of page numbers, so the
+ * replacement policies of replacement.h apply. A miss
+ * in all levels walks the page tables, whose entries
+ * get addresses of their own so that the walk can be
+ * run through the data cache.
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tlb.h"
+
+/* Page offset bits of the two page sizes */
+#define SMALL_PAGE_BITS 12
+#define HUGE_PAGE_BITS  21
+
+/* Added to the page number of a 2MB page, so that it never looks
+ * like a 4KB page in a level that holds both. A 4KB page number has
+ * at most 52 bits, and bit 52 still fits in the line word of a cache
+ * (see cache.h) whatever its s. */
+#define HUGE_PAGE_KEY (1UL << 52)
+
+/* Base of the linear array of the page table level that maps
+ * 2^(3 + 9*level) bytes per entry (1 is the PT, 4 the PML4) */
+#define TABLE_BASE(level) ((unsigned long)(0x8 + (level)) << 56)
+
+/* Function - parse_page_sizes
+ * Mapping a page size from the config file to TLB_PAGE_ bits.
+ * ---------------------------------------------------
+ * Return value:
+ * The bits, or -1 for an unknown size.
+ * --------------------------------------------------
+ * */
+static int parse_page_sizes(const char *name){
+    if (strcmp(name, "4k") == 0)
+        return TLB_PAGE_4K;
+    if (strcmp(name, "2m") == 0)
+        return TLB_PAGE_2M;
+    if (strcmp(name, "any") == 0)
+        return TLB_PAGE_ANY;
+    return -1;
+}
+
+/* Function - build_path
+ * Listing the levels that hold one page size by depth. Each
+ * depth can have at most one of them, but may have none.
+ * ---------------------------------------------------
+ * Return value:
+ * Number of levels on the path, -1 if a depth has two.
+ * --------------------------------------------------
+ * */
+static int build_path(struct tlb *tlb, int page_size, int *path){
+    int depth;
+    int count = 0;
+    int k;
+
+    for (depth = 1; depth <= TLB_MAX_LEVELS; depth++) {
+        int found = -1;
+        for (k = 0; k < tlb->level_count; k++) {
+            if (tlb->levels[k].depth != depth ||
+                !(tlb->levels[k].page_sizes & page_size))
+                continue;
+            if (found >= 0)
+                return -1;
+            found = k;
+        }
+        if (found >= 0)
+            path[count++] = found;
+    }
+    return count;
+}
+
+/* Function - tlb_load
+ * Reading the TLB levels, huge page ranges and walk costs
+ * from a config file and allocating the TLBs.
+ * ---------------------------------------------------
+ * Input parameters:
+ * TLB to set up and path of the config file.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, -1 on error after printing it to stderr.
+ * --------------------------------------------------
+ * */
+int tlb_load(struct tlb *tlb, const char *path){
+    FILE *config = fopen(path, "r");
+    char line[256];
+    char name[TLB_NAME_MAX];
+    char option[16];
+    char sizes[16];
+    const struct replacement_policy *replacement;
+    struct huge_region *region;
+    int depth, page_sizes, set_bits, number_of_lines, latency;
+    int fields;
+    int line_number = 0;
+
+    memset(tlb, 0, sizeof(*tlb));
+    tlb->walk_memory_cycles = -1;
+    if (config == NULL) {
+        fprintf(stderr, "%s: can't open TLB config\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), config) != NULL) {
+        line_number++;
+        // Dropping comments, then skipping blank lines.
+        line[strcspn(line, "#\n")] = '\0';
+        if (sscanf(line, " %15s", name) != 1)
+            continue;
+
+        if (strcmp(name, "walk") == 0) {
+            fields = sscanf(line, " %*s %d %d %15s",
+                            &tlb->walk_cache_cycles,
+                            &tlb->walk_memory_cycles, option);
+            if (fields < 2 || tlb->walk_cache_cycles < 0 ||
+                tlb->walk_memory_cycles < 0 ||
+                (fields == 3 && strcmp(option, "cached") != 0))
+                goto bad_line;
+            tlb->walk_cached = (fields == 3);
+            continue;
+        }
+        if (strcmp(name, "hugepages") == 0) {
+            if (tlb->region_count == TLB_MAX_REGIONS)
+                goto bad_line;
+            region = tlb->regions + tlb->region_count;
+            if (sscanf(line, " %*s %15s", option) == 1 &&
+                strcmp(option, "all") == 0) {
+                region->start = 0;
+                region->end = ~0UL;
+            } else if (sscanf(line, " %*s %lx-%lx", &region->start,
+                              &region->end) != 2 ||
+                       region->start > region->end) {
+                goto bad_line;
+            }
+            tlb->region_count++;
+            continue;
+        }
+
+        fields = sscanf(line, " %*s %d %15s %d %d %d %15s", &depth, sizes,
+                        &set_bits, &number_of_lines, &latency, option);
+        if (fields < 5 || tlb->level_count == TLB_MAX_LEVELS ||
+            depth < 1 || depth > TLB_MAX_LEVELS ||
+            (page_sizes = parse_page_sizes(sizes)) < 0 ||
+            set_bits < 0 || set_bits > 30 || number_of_lines < 1 ||
+            latency < 0)
+            goto bad_line;
+        replacement = replacement_find(fields == 6 ? option : "lru");
+        if (replacement == NULL)
+            goto bad_line;
+        if (!replacement_supports(replacement, number_of_lines)) {
+            fprintf(stderr, "%s:%d: %s needs E to be a power of 2\n",
+                    path, line_number, replacement->name);
+            goto error;
+        }
+
+        struct tlb_level *level = tlb->levels + tlb->level_count;
+        strcpy(level->name, name);
+        level->depth = depth;
+        level->page_sizes = page_sizes;
+        level->latency = latency;
+        if (cache_init(&level->cache, set_bits, number_of_lines, 0,
+                       replacement) < 0) {
+            fprintf(stderr, "%s:%d: not enough memory for %s\n",
+                    path, line_number, name);
+            goto error;
+        }
+        tlb->level_count++;
+    }
+    fclose(config);
+
+    tlb->small_depth = build_path(tlb, TLB_PAGE_4K, tlb->small_path);
+    tlb->huge_depth = build_path(tlb, TLB_PAGE_2M, tlb->huge_path);
+    if (tlb->small_depth < 1 || tlb->huge_depth < 0 ||
+        (tlb->region_count > 0 && tlb->huge_depth < 1) ||
+        tlb->walk_memory_cycles < 0) {
+        fprintf(stderr, "%s: needs a walk line and a TLB for every page "
+                "size in use, at most one per depth\n", path);
+        tlb_free(tlb);
+        return -1;
+    }
+    return 0;
+
+bad_line:
+    fprintf(stderr, "%s:%d: expected '<name> <depth> <4k|2m|any> <s> <E> "
+            "<latency> [<replacement>]', 'hugepages <start>-<end>|all' or "
+            "'walk <cache cycles> <memory cycles> [cached]'\n",
+            path, line_number);
+error:
+    fclose(config);
+    tlb_free(tlb);
+    return -1;
+}
+
+/* Function - tlb_free
+ * Releasing the caches of all TLB levels.
+ * */
+void tlb_free(struct tlb *tlb){
+    int k;
+
+    for (k = 0; k < tlb->level_count; k++)
+        cache_free(&tlb->levels[k].cache);
+    tlb->level_count = 0;
+}
+
+/* Function - is_huge
+ * Checking whether an address is on a 2MB page.
+ * */
+static int is_huge(struct tlb *tlb, unsigned long address){
+    int k;
+
+    for (k = 0; k < tlb->region_count; k++) {
+        if (address >= tlb->regions[k].start &&
+            address <= tlb->regions[k].end)
+            return 1;
+    }
+    return 0;
+}
+
+/* Function - tlb_translate
+ * Probing the TLBs for the page of an address, the smallest
+ * depth first, and filling the ones that missed. If all miss
+ * the addresses of the page table entries to read are worked
+ * out, from the root down to the entry that maps the page.
+ * ---------------------------------------------------
+ * Input parameters:
+ * TLB, virtual address and where to store the walk.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on a TLB hit, the number of entries in walk[] otherwise.
+ * --------------------------------------------------
+ * */
+int tlb_translate(struct tlb *tlb, unsigned long address,
+                  unsigned long walk[TLB_WALK_MAX]){
+    int huge = is_huge(tlb, address);
+    int *path = huge ? tlb->huge_path : tlb->small_path;
+    int depth_count = huge ? tlb->huge_depth : tlb->small_depth;
+    unsigned long page = huge ? (address >> HUGE_PAGE_BITS) | HUGE_PAGE_KEY :
+                                address >> SMALL_PAGE_BITS;
+    unsigned long victim;
+    int hit_depth = depth_count;
+    int level;
+    int count = 0;
+    int k;
+
+    tlb->access_count++;
+    for (k = 0; k < depth_count; k++) {
+        struct tlb_level *tlb_level = tlb->levels + path[k];
+        tlb->cycle_count += tlb_level->latency;
+        if (cache_lookup(&tlb_level->cache, page)) {
+            tlb_level->hit_count++;
+            hit_depth = k;
+            break;
+        }
+        tlb_level->miss_count++;
+    }
+    for (k = hit_depth-1; k >= 0; k--)
+        cache_insert(&tlb->levels[path[k]].cache, page, &victim);
+    if (hit_depth < depth_count)
+        return 0;
+
+    tlb->walk_count++;
+    // A 2MB page is mapped by its PD entry, one level above the PT.
+    for (level = 4; level >= (huge ? 2 : 1); level--)
+        walk[count++] = TABLE_BASE(level) +
+                        ((address >> (3 + 9*level)) << 3);
+    return count;
+}
+
+/* Function - tlb_walk_read
+ * Charging one page table read of a walk.
+ * */
+void tlb_walk_read(struct tlb *tlb, int hit){
+    int cycles = hit ? tlb->walk_cache_cycles : tlb->walk_memory_cycles;
+
+    tlb->walk_read_count++;
+    tlb->walk_cache_hit_count += (hit != 0);
+    tlb->walk_cycle_count += cycles;
+    tlb->cycle_count += cycles;
+}
+
+/* Function - tlb_report
+ * Printing a table of per-level counts, the walks and the
+ * average translation cost in cycles.
+ * */
+void tlb_report(struct tlb *tlb, FILE *out){
+    int k;
+
+    fprintf(out, "%-8s %12s %12s %8s\n", "tlb", "hits", "misses", "miss%");
+    for (k = 0; k < tlb->level_count; k++) {
+        struct tlb_level *level = tlb->levels + k;
+        unsigned long probes = level->hit_count + level->miss_count;
+        fprintf(out, "%-8s %12lu %12lu %7.2f%%\n", level->name,
+                level->hit_count, level->miss_count,
+                probes ? 100.0 * level->miss_count / probes : 0.0);
+    }
+    fprintf(out, "walks:%lu walk-reads:%lu cached:%lu walk-cycles:%lu "
+            "(%.1f per walk)\n", tlb->walk_count, tlb->walk_read_count,
+            tlb->walk_cache_hit_count, tlb->walk_cycle_count,
+            tlb->walk_count ?
+            (double)tlb->walk_cycle_count / tlb->walk_count : 0.0);
+    fprintf(out, "translation: %.2f cycles over %lu accesses\n",
+            tlb->access_count ?
+            (double)tlb->cycle_count / tlb->access_count : 0.0,
+            tlb->access_count);
+}
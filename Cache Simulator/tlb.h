@@ -0,0 +1,113 @@
+/*
+ * tlb.h - Multi-level TLB with x86-64 style page walks
+ *
+ * The TLB levels are read from a config file with one level per line:
+ *
+ *     <name> <depth> <4k|2m|any> <s> <E> <latency> [<replacement>]
+ *     hugepages <start>-<end>|all
+ *     walk <cache cycles> <memory cycles> [cached]
+ *
+ * A level holds translations of one page size, or of both ('any',
+ * like a shared STLB), in 2^s sets of E entries. A translation
+ * probes the levels for its page size from depth 1 down, charging
+ * each probe's latency, and fills the levels that missed. Addresses
+ * in a 'hugepages' range (hex, any number of lines) are on 2MB pages,
+ * all others on 4KB pages. '#' starts a comment.
+ *
+ * When every level misses, the page tables are walked: four 8 byte
+ * entries (PML4, PDPT, PD and PT) for a 4KB page, three for a 2MB
+ * page. Each level of the page tables is laid out as one linear
+ * array at its own base above the user address space. A walk read
+ * costs the memory cycles, unless the walk is 'cached', in which
+ * case the caller runs it through the data cache and it costs the
+ * cache cycles on a hit.
+ */
+
+#ifndef CSIM_TLB_H
+#define CSIM_TLB_H
+
+#include <stdio.h>
+#include "cache.h"
+
+#define TLB_MAX_LEVELS 8
+#define TLB_MAX_REGIONS 16
+#define TLB_NAME_MAX 16
+
+/* Most page table entries read by one walk */
+#define TLB_WALK_MAX 4
+
+/* Page sizes a level holds */
+#define TLB_PAGE_4K  1
+#define TLB_PAGE_2M  2
+#define TLB_PAGE_ANY (TLB_PAGE_4K | TLB_PAGE_2M)
+
+/* Definining the structure tlb level - one TLB of the hierarchy.
+ * page_sizes - TLB_PAGE_ bits of the pages it holds.
+ * cache - Entries keyed by page number, with 'b' = 0.
+ * */
+struct tlb_level {
+    char name[TLB_NAME_MAX];
+    int depth;
+    int page_sizes;
+    int latency;
+    struct cache cache;
+    unsigned long hit_count;
+    unsigned long miss_count;
+};
+
+/* Definining the structure huge region - addresses start..end on
+ * 2MB pages. */
+struct huge_region {
+    unsigned long start;
+    unsigned long end;
+};
+
+/* Definining the structure tlb.
+ * small_path, huge_path - Indices into levels of the TLBs probed for
+ *                         a 4KB and a 2MB page, by depth.
+ * walk_cached - Set if walk reads go through the data cache.
+ * cycle_count - Cycles of all translations, probes and walks.
+ * walk_cycle_count - The part of cycle_count spent walking.
+ * */
+struct tlb {
+    int level_count;
+    struct tlb_level levels[TLB_MAX_LEVELS];
+    int small_path[TLB_MAX_LEVELS];
+    int small_depth;
+    int huge_path[TLB_MAX_LEVELS];
+    int huge_depth;
+    int region_count;
+    struct huge_region regions[TLB_MAX_REGIONS];
+    int walk_cache_cycles;
+    int walk_memory_cycles;
+    int walk_cached;
+    unsigned long access_count;
+    unsigned long walk_count;
+    unsigned long walk_read_count;
+    unsigned long walk_cache_hit_count;
+    unsigned long cycle_count;
+    unsigned long walk_cycle_count;
+};
+
+/* Reads a config file and sets up empty TLBs, returns 0 on success
+ * and -1 after printing the problem to stderr */
+int tlb_load(struct tlb *tlb, const char *path);
+
+/* Releases the TLBs */
+void tlb_free(struct tlb *tlb);
+
+/* Translates a virtual address. Returns 0 on a TLB hit, otherwise the
+ * number of page table entries the walk reads, with their addresses
+ * in walk[] (root first). Each of them has to be charged with
+ * tlb_walk_read. */
+int tlb_translate(struct tlb *tlb, unsigned long address,
+                  unsigned long walk[TLB_WALK_MAX]);
+
+/* Charges one walk read, 'hit' saying whether the data cache had it
+ * (always 0 for walks that aren't cached) */
+void tlb_walk_read(struct tlb *tlb, int hit);
+
+/* Prints the per-level counts, the walks and the translation cost */
+void tlb_report(struct tlb *tlb, FILE *out);
+
+#endif /* CSIM_TLB_H */
@@ -0,0 +1,603 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay 
+ * 
+ * DESCRIPTION:
+ * Trace reader for the cache simulator. The trace file
+ * is mapped into memory and decoded in place, which is 
+ * many times faster than reading it with fscanf. The 
+ * hex and decimal fields are converted through a lookup
+ * table, and lines that aren't accesses are skipped 
+ * with memchr, which is vectorized in libc.
+ * The data is always followed by a NUL byte. For a 
+ * mapped file that is the zero fill of its last page, 
+ * so files whose size is a multiple of the page size 
+ * are read instead. The NUL stops every field scan, so
+ * the parser only checks for the end between lines.
+ * Compressed traces are decoded on a thread of their
+ * own into a small ring of batches, which the reader
+ * copies out of, the way parallel.c hands batches to
+ * its workers.
+ ********************************************************/
+
+/* madvise isn't part of C99 or POSIX */
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Batches the decoder thread of a compressed trace runs ahead */
+#define PIPELINE_QUEUE 4
+
+/* Size that is stored in a varint after the tag byte */
+#define SIZE_ESCAPE 63
+
+/* Definining the structure trace_pipeline - the decoder thread of a
+ * compressed trace and its ring of batches.
+ * ring, counts - Batches tail..tail+queued-1 are decoded, the thread
+ *                decodes into ring[head].
+ * offset - Accesses of ring[tail] already handed out.
+ * done - Set by the thread after the last batch, or by trace_close
+ *        to stop it early.
+ * */
+struct trace_pipeline {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    struct trace_access ring[PIPELINE_QUEUE][TRACE_BATCH];
+    int counts[PIPELINE_QUEUE];
+    int head;
+    int tail;
+    int queued;
+    int offset;
+    int done;
+};
+
+/* Digit values of hex characters, NOT_HEX for everything else. 
+ * Decimal digits have the same values, so the size field uses 
+ * the table too. */
+#define NOT_HEX 16
+static unsigned char hex_value[256];
+static int hex_value_ready = 0;
+
+/* Function - init_hex_value
+ * Filling in the hex_value lookup table.
+ * */
+static void init_hex_value(void){
+    int c;
+
+    memset(hex_value, NOT_HEX, sizeof(hex_value));
+    hex_value_ready = 1;
+    for (c = '0'; c <= '9'; c++)
+        hex_value[c] = c - '0';
+    for (c = 'a'; c <= 'f'; c++)
+        hex_value[c] = c - 'a' + 10;
+    for (c = 'A'; c <= 'F'; c++)
+        hex_value[c] = c - 'A' + 10;
+}
+
+#ifdef __SSE2__
+/* Function - parse_hex16
+ * Decoding the run of hex digits at the start of 16 bytes
+ * without a branch per digit. Classifies all 16 bytes at
+ * once, zeroes everything from the first non-digit on, 
+ * packs the nibbles into a 64 bit number and shifts off
+ * the unused low digits.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Pointer with at least 16 readable bytes, and where to 
+ * store the number of digits.
+ * --------------------------------------------------
+ * Return value:
+ * Value of the digits (undefined if there are none).
+ * --------------------------------------------------
+ * */
+static inline unsigned long parse_hex16(const unsigned char *p, int *ndigits){
+    __m128i c = _mm_loadu_si128((const __m128i *)p);
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i is_alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    unsigned mask = _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+    int n = __builtin_ctz(~mask);
+    __m128i nibble, keep, pairs;
+    unsigned long value;
+
+    // '0'..'9' -> 0..9 and 'a'..'f' -> 10..15 (+9 for letters)
+    nibble = _mm_add_epi8(_mm_and_si128(c, _mm_set1_epi8(0x0f)),
+                          _mm_andnot_si128(is_digit, _mm_set1_epi8(9)));
+    keep = _mm_cmplt_epi8(_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                        11, 12, 13, 14, 15), 
+                          _mm_set1_epi8(n));
+    nibble = _mm_and_si128(nibble, keep);
+    // Pairs of digits into bytes, high digit first.
+    pairs = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(nibble, _mm_set1_epi16(0x00ff)), 4),
+        _mm_srli_epi16(nibble, 8));
+    pairs = _mm_packus_epi16(pairs, pairs);
+    value = __builtin_bswap64((unsigned long)_mm_cvtsi128_si64(pairs));
+    *ndigits = n;
+    return n ? value >> (4*(16 - n)) : 0;
+}
+#endif
+
+/* Function - read_all
+ * Reading a whole file that can't be mapped (e.g. a pipe),
+ * and NUL terminating it.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Reader and file descriptor.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 on error.
+ * --------------------------------------------------
+ * */
+static int read_all(struct trace_reader *reader, int fd){
+    size_t capacity = 1 << 16;
+    ssize_t n;
+    char *data;
+
+    reader->data = malloc(capacity);
+    reader->length = 0;
+    if (reader->data == NULL)
+        return -1;
+    while ((n = read(fd, reader->data + reader->length, 
+                     capacity - reader->length - 1)) > 0) {
+        reader->length += n;
+        if (reader->length == capacity - 1) {
+            capacity *= 2;
+            if ((data = realloc(reader->data, capacity)) == NULL) {
+                free(reader->data);
+                return -1;
+            }
+            reader->data = data;
+        }
+    }
+    if (n < 0) {
+        free(reader->data);
+        return -1;
+    }
+    reader->data[reader->length] = '\0';
+    return 0;
+}
+
+/* Function - get_varint
+ * Decoding a varint of a compressed trace.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Where the varint starts (moved past it), end of the data
+ * and where to store the value.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success, -1 if the varint runs past the end or is
+ * too long for 64 bits.
+ * --------------------------------------------------
+ * */
+static inline int get_varint(const unsigned char **p, 
+                             const unsigned char *end, unsigned long *value){
+    const unsigned char *q = *p;
+    unsigned long result = 0;
+    int shift = 0;
+
+    do {
+        if (q == end || shift > 63)
+            return -1;
+        result |= (unsigned long)(*q & 0x7f) << shift;
+        shift += 7;
+    } while (*q++ & 0x80);
+    *p = q;
+    *value = result;
+    return 0;
+}
+
+/* Function - put_varint
+ * Encoding a varint of a compressed trace.
+ * ---------------------------------------------------
+ * Return value:
+ * Number of bytes written, at most 10.
+ * --------------------------------------------------
+ * */
+static inline int put_varint(unsigned char *p, unsigned long value){
+    int n = 0;
+
+    while (value >= 0x80) {
+        p[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (unsigned char)value;
+    return n;
+}
+
+/* Function - parse_binary
+ * Decoding the next accesses of a compressed trace. An
+ * access that runs past the end ends the trace.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Reader, array to decode into and its size.
+ * --------------------------------------------------
+ * Return value:
+ * Number of accesses decoded, 0 once the trace is done.
+ * --------------------------------------------------
+ * */
+static int parse_binary(struct trace_reader *reader,
+                        struct trace_access *batch, int max){
+    static const char ops[4] = {'I', 'L', 'S', 'M'};
+    const unsigned char *p = (const unsigned char *)reader->pos;
+    const unsigned char *end = (const unsigned char *)reader->data + 
+                               reader->length;
+    unsigned long size, delta;
+    int count = 0;
+    int tag, side;
+
+    while (count < max && p < end) {
+        tag = *p++;
+        size = tag >> 2;
+        if ((size == SIZE_ESCAPE && get_varint(&p, end, &size) < 0) ||
+            get_varint(&p, end, &delta) < 0) {
+            p = end;
+            break;
+        }
+        // Undoing the zigzag encoding of the delta.
+        side = (tag & 3) != 0;
+        reader->last_address[side] += (delta >> 1) ^ -(delta & 1);
+        batch[count].address = reader->last_address[side];
+        batch[count].size = (unsigned)size;
+        batch[count].op = ops[tag & 3];
+        count++;
+    }
+    reader->pos = (const char *)p;
+    return count;
+}
+
+/* Function - decode_thread
+ * Thread body, decoding a compressed trace into the ring of
+ * its pipeline until the trace is done or trace_close
+ * stops it.
+ * */
+static void *decode_thread(void *arg){
+    struct trace_reader *reader = arg;
+    struct trace_pipeline *pipeline = reader->pipeline;
+    int count;
+
+    for (;;) {
+        count = parse_binary(reader, pipeline->ring[pipeline->head],
+                             TRACE_BATCH);
+
+        pthread_mutex_lock(&pipeline->lock);
+        if (count > 0) {
+            pipeline->counts[pipeline->head] = count;
+            pipeline->head = (pipeline->head + 1) % PIPELINE_QUEUE;
+            pipeline->queued++;
+        } else {
+            pipeline->done = 1;
+        }
+        pthread_cond_signal(&pipeline->not_empty);
+        while (pipeline->queued == PIPELINE_QUEUE && !pipeline->done)
+            pthread_cond_wait(&pipeline->not_full, &pipeline->lock);
+        if (pipeline->done) {
+            pthread_mutex_unlock(&pipeline->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+}
+
+/* Function - start_pipeline
+ * Starting the decoder thread of a compressed trace. If
+ * that fails, the reader is left to decode by itself.
+ * */
+static void start_pipeline(struct trace_reader *reader){
+    struct trace_pipeline *pipeline = malloc(sizeof(struct trace_pipeline));
+
+    if (pipeline == NULL)
+        return;
+    pipeline->head = 0;
+    pipeline->tail = 0;
+    pipeline->queued = 0;
+    pipeline->offset = 0;
+    pipeline->done = 0;
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->not_empty, NULL);
+    pthread_cond_init(&pipeline->not_full, NULL);
+    reader->pipeline = pipeline;
+    if (pthread_create(&pipeline->thread, NULL, decode_thread, reader) != 0) {
+        pthread_mutex_destroy(&pipeline->lock);
+        pthread_cond_destroy(&pipeline->not_empty);
+        pthread_cond_destroy(&pipeline->not_full);
+        free(pipeline);
+        reader->pipeline = NULL;
+    }
+}
+
+/* Function - pipeline_next_batch
+ * Copying the next decoded accesses out of the ring of the
+ * decoder thread, and handing a batch back once all of it
+ * has been copied.
+ * ---------------------------------------------------
+ * Return value:
+ * Number of accesses copied, 0 once the trace is done.
+ * --------------------------------------------------
+ * */
+static int pipeline_next_batch(struct trace_pipeline *pipeline,
+                               struct trace_access *batch, int max){
+    int count;
+
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->queued == 0 && !pipeline->done)
+        pthread_cond_wait(&pipeline->not_empty, &pipeline->lock);
+    if (pipeline->queued == 0) {
+        pthread_mutex_unlock(&pipeline->lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    count = pipeline->counts[pipeline->tail] - pipeline->offset;
+    if (count > max)
+        count = max;
+    memcpy(batch, pipeline->ring[pipeline->tail] + pipeline->offset,
+           count*sizeof(struct trace_access));
+    pipeline->offset += count;
+    if (pipeline->offset == pipeline->counts[pipeline->tail]) {
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->tail = (pipeline->tail + 1) % PIPELINE_QUEUE;
+        pipeline->queued--;
+        pipeline->offset = 0;
+        pthread_cond_signal(&pipeline->not_full);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    return count;
+}
+
+/* Function - trace_open
+ * Mapping a trace file for reading, falling back to 
+ * reading it into memory when it isn't a regular file.
+ * A compressed trace gets a decoder thread.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Reader to set up and path of the trace file.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 on error.
+ * --------------------------------------------------
+ * */
+int trace_open(struct trace_reader *reader, const char *path){
+    struct stat st;
+    int fd;
+    int status = 0;
+
+    if (!hex_value_ready)
+        init_hex_value();
+    if (path == NULL || (fd = open(path, O_RDONLY)) < 0)
+        return -1;
+
+    reader->mapped = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && 
+        st.st_size % sysconf(_SC_PAGESIZE) != 0) {
+        reader->length = st.st_size;
+        reader->data = mmap(NULL, reader->length, PROT_READ, MAP_PRIVATE, 
+                            fd, 0);
+        if (reader->data != MAP_FAILED) {
+            reader->mapped = 1;
+            madvise(reader->data, reader->length, MADV_SEQUENTIAL);
+        }
+    }
+    if (!reader->mapped)
+        status = read_all(reader, fd);
+    close(fd);
+    reader->pos = reader->data;
+    reader->compressed = 0;
+    reader->pipeline = NULL;
+    if (status == 0 && reader->length >= TRACE_MAGIC_LENGTH &&
+        memcmp(reader->data, TRACE_MAGIC, TRACE_MAGIC_LENGTH) == 0) {
+        reader->pos += TRACE_MAGIC_LENGTH;
+        reader->compressed = 1;
+        reader->last_address[0] = 0;
+        reader->last_address[1] = 0;
+        start_pipeline(reader);
+    }
+    return status;
+}
+
+/* Function - parse_text
+ * Decoding the next accesses of a text trace. Addresses
+ * are decoded 16 hex digits at a time with SSE2 when 
+ * there is room to load them, and digit by digit 
+ * otherwise.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Reader, array to decode into and its size.
+ * --------------------------------------------------
+ * Return value:
+ * Number of accesses decoded, 0 once the trace is done.
+ * --------------------------------------------------
+ * */
+static int parse_text(struct trace_reader *reader,
+                      struct trace_access *batch, int max){
+    const unsigned char *p = (const unsigned char *)reader->pos;
+    const unsigned char *end = (const unsigned char *)reader->data + 
+                               reader->length;
+    const unsigned char *eol;
+    unsigned long address;
+    unsigned size;
+    unsigned digit;
+    int count = 0;
+    int ndigits;
+    char op;
+
+    while (count < max && p < end) {
+        // Skipping the leading space(s) to the op.
+        while (*p == ' ')
+            p++;
+        op = p[0];
+        if ((op != 'I' && op != 'L' && op != 'S' && op != 'M') || 
+            p[1] != ' ')
+            goto skip_line;
+        p += 2;
+        while (*p == ' ')
+            p++;
+
+        // Address, in hex.
+        address = 0;
+#ifdef __SSE2__
+        if (end - p >= 16) {
+            address = parse_hex16(p, &ndigits);
+            p += ndigits;
+        }
+#endif
+        while ((digit = hex_value[*p]) < NOT_HEX) {
+            address = (address << 4) | digit;
+            p++;
+        }
+        if (*p != ',')
+            goto skip_line;
+        p++;
+
+        // Size, in decimal.
+        size = 0;
+        while ((digit = hex_value[*p]) < 10) {
+            size = size*10 + digit;
+            p++;
+        }
+
+        batch[count].address = address;
+        batch[count].size = size;
+        batch[count].op = op;
+        count++;
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+
+    skip_line:
+        if (p >= end)
+            break;
+        eol = memchr(p, '\n', end - p);
+        p = eol ? eol + 1 : end;
+    }
+    reader->pos = (const char *)p;
+    return count;
+}
+
+/* Function - trace_next_batch
+ * Decoding the next accesses of a trace, or taking them
+ * from the decoder thread of a compressed one.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Reader, array to decode into and its size.
+ * --------------------------------------------------
+ * Return value:
+ * Number of accesses decoded, 0 once the trace is done.
+ * --------------------------------------------------
+ * */
+int trace_next_batch(struct trace_reader *reader, 
+                     struct trace_access *batch, int max){
+    if (reader->pipeline != NULL)
+        return pipeline_next_batch(reader->pipeline, batch, max);
+    if (reader->compressed)
+        return parse_binary(reader, batch, max);
+    return parse_text(reader, batch, max);
+}
+
+/* Function - trace_close
+ * Stopping the decoder thread, if there is one, and 
+ * unmapping (or freeing) the trace data.
+ * */
+void trace_close(struct trace_reader *reader){
+    struct trace_pipeline *pipeline = reader->pipeline;
+
+    if (pipeline != NULL) {
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->done = 1;
+        pthread_cond_signal(&pipeline->not_full);
+        pthread_mutex_unlock(&pipeline->lock);
+        pthread_join(pipeline->thread, NULL);
+        pthread_mutex_destroy(&pipeline->lock);
+        pthread_cond_destroy(&pipeline->not_empty);
+        pthread_cond_destroy(&pipeline->not_full);
+        free(pipeline);
+        reader->pipeline = NULL;
+    }
+    if (reader->mapped)
+        munmap(reader->data, reader->length);
+    else
+        free(reader->data);
+    reader->data = NULL;
+    reader->length = 0;
+}
+
+/* Function - trace_compress
+ * Writing the accesses left in a trace to a file in the
+ * compressed format of trace.h, a batch at a time.
+ * ---------------------------------------------------
+ * Input parameters: 
+ * Open trace (text or compressed) and path to write to.
+ * --------------------------------------------------
+ * Return value:
+ * 0 on success and -1 on error.
+ * --------------------------------------------------
+ * */
+int trace_compress(struct trace_reader *reader, const char *path){
+    struct trace_access batch[TRACE_BATCH];
+    unsigned long last_address[2] = {0, 0};
+    unsigned long delta;
+    unsigned char *buffer;
+    FILE *out;
+    size_t n;
+    int count;
+    int k;
+    int op, side;
+    int status = 0;
+
+    // A tag byte and two varints per access at most.
+    buffer = malloc(TRACE_BATCH * 21);
+    if (buffer == NULL || (out = fopen(path, "wb")) == NULL) {
+        free(buffer);
+        return -1;
+    }
+    if (fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_LENGTH, out) != TRACE_MAGIC_LENGTH)
+        status = -1;
+    while (status == 0 &&
+           (count = trace_next_batch(reader, batch, TRACE_BATCH)) > 0) {
+        n = 0;
+        for (k = 0; k < count; k++) {
+            switch(batch[k].op) {
+                case 'L': op = 1; break;
+                case 'S': op = 2; break;
+                case 'M': op = 3; break;
+                default: op = 0; break;
+            }
+            side = op != 0;
+            delta = batch[k].address - last_address[side];
+            last_address[side] = batch[k].address;
+            if (batch[k].size < SIZE_ESCAPE) {
+                buffer[n++] = (unsigned char)(op | batch[k].size << 2);
+            } else {
+                buffer[n++] = (unsigned char)(op | SIZE_ESCAPE << 2);
+                n += put_varint(buffer + n, batch[k].size);
+            }
+            // Zigzag encoding, so small negative deltas are short too.
+            n += put_varint(buffer + n,
+                            delta << 1 ^ -(delta >> 63));
+        }
+        if (fwrite(buffer, 1, n, out) != n)
+            status = -1;
+    }
+    if (fclose(out) != 0)
+        status = -1;
+    free(buffer);
+    return status;
+}
@@ -0,0 +1,79 @@
+/* 
+ * trace.h - Reader for valgrind lackey style memory traces
+ *
+ * Each line of a trace is " <op> <hex address>,<decimal size>", with 
+ * op one of I (instruction fetch, no leading space), L, S or M. Any 
+ * other line (e.g. valgrind's "==pid==" banner) is skipped.
+ *
+ * Traces can also be stored compressed (see trace_compress), which
+ * trace_open recognizes by their first bytes, TRACE_MAGIC. After the
+ * magic, each access is a tag byte followed by one or two varints
+ * (7 bits per byte, low bits first, the top bit set on all but the
+ * last byte):
+ *
+ *     tag = op | size << 2      op: 0 I, 1 L, 2 S, 3 M
+ *     [size]                    only if the size field is 63
+ *     delta                     zigzag encoded address delta
+ *
+ * The delta is from the previous instruction fetch for an I and from
+ * the previous data access otherwise, so it mostly fits one or two
+ * bytes. A compressed trace is decoded by a thread of its own, a few
+ * batches ahead of the simulator. Decoding stops at the first access
+ * that runs past the end of the file.
+ */
+
+#ifndef CSIM_TRACE_H
+#define CSIM_TRACE_H
+
+#include <stddef.h>
+
+/* Number of accesses decoded per trace_next_batch call in csim */
+#define TRACE_BATCH 4096
+
+/* First bytes of a compressed trace */
+#define TRACE_MAGIC "CSIMTRC1"
+#define TRACE_MAGIC_LENGTH 8
+
+struct trace_pipeline;
+
+/* One decoded trace line */
+struct trace_access {
+    unsigned long address;
+    unsigned size;
+    char op;
+};
+
+/* An open trace. The file is mapped (or read, if it can't be mapped) 
+ * in full and parsed in place.
+ * last_address - Addresses the deltas of a compressed trace are from,
+ *                the instruction one first.
+ * pipeline - Decoder thread of a compressed trace, NULL for a text
+ *            trace or if the thread couldn't be started, in which
+ *            case trace_next_batch decodes. The thread works on the
+ *            reader, so it mustn't be moved until trace_close.
+ * */
+struct trace_reader {
+    char *data;
+    size_t length;
+    int mapped;
+    const char *pos;
+    int compressed;
+    unsigned long last_address[2];
+    struct trace_pipeline *pipeline;
+};
+
+/* Opens a trace file, returns 0 on success and -1 on error */
+int trace_open(struct trace_reader *reader, const char *path);
+
+/* Decodes up to max accesses into batch, returns how many (0 at the end) */
+int trace_next_batch(struct trace_reader *reader, 
+                     struct trace_access *batch, int max);
+
+/* Releases the trace */
+void trace_close(struct trace_reader *reader);
+
+/* Writes the rest of a trace to 'path' in the compressed format,
+ * returns 0 on success and -1 on error */
+int trace_compress(struct trace_reader *reader, const char *path);
+
+#endif /* CSIM_TRACE_H */
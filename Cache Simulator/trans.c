@@ -15,10 +15,15 @@
  *
  * A transpose function is evaluated by counting the number of misses
  * on a 1KB direct mapped cache with a block size of 32 bytes.
+ *
+ * The matrices are read and written through LOAD and STORE (see
+ * recorder.h), so that trans_sim.c can record the accesses in
+ * process when built with -DCSIM_RECORD.
  */ 
 #include <stdio.h>
 #include "cachelab.h"
 #include "contracts.h"
+#include "recorder.h"
 
 int is_transpose(int M, int N, int A[N][M], int B[M][N]);
 
@@ -49,23 +54,23 @@ void transpose_submit(int M, int N, int A[N][M], int B[M][N])
         for (i = 0; i < N; i=i+8) {
             for (j = 0; j < M; j=j+8) {
                 for (i1 = i; i1 < i+8; i1=i1+1) {
-                        t0 = A[i1][j];
-                        t1 = A[i1][j+1];
-                        t2 = A[i1][j+2];
-                        t3 = A[i1][j+3];
-                        t4 = A[i1][j+4];
-                        t5 = A[i1][j+5];
-                        t6 = A[i1][j+6];
-                        t7 = A[i1][j+7];
+                        t0 = LOAD(A[i1][j]);
+                        t1 = LOAD(A[i1][j+1]);
+                        t2 = LOAD(A[i1][j+2]);
+                        t3 = LOAD(A[i1][j+3]);
+                        t4 = LOAD(A[i1][j+4]);
+                        t5 = LOAD(A[i1][j+5]);
+                        t6 = LOAD(A[i1][j+6]);
+                        t7 = LOAD(A[i1][j+7]);
 
-                        B[j][i1] = t0;
-                        B[j+1][i1] = t1;
-                        B[j+2][i1] = t2;
-                        B[j+3][i1] = t3;
-                        B[j+4][i1] = t4;
-                        B[j+5][i1] = t5;
-                        B[j+6][i1] = t6;
-                        B[j+7][i1] = t7;
+                        STORE(B[j][i1], t0);
+                        STORE(B[j+1][i1], t1);
+                        STORE(B[j+2][i1], t2);
+                        STORE(B[j+3][i1], t3);
+                        STORE(B[j+4][i1], t4);
+                        STORE(B[j+5][i1], t5);
+                        STORE(B[j+6][i1], t6);
+                        STORE(B[j+7][i1], t7);
                 }
             }
         }    
@@ -82,26 +87,26 @@ void transpose_submit(int M, int N, int A[N][M], int B[M][N])
            for (j = 0; j < M; j=j+8) {
             for (i = 0; i < N; i=i+8) {
                 for (i1 = i; i1 < i+8; i1=i1+1) {
-                        t0= A[i1][j];
-                        t1= A[i1][j+1];
-                        t2= A[i1][j+2];
-                        t3= A[i1][j+3];
+                        t0 = LOAD(A[i1][j]);
+                        t1 = LOAD(A[i1][j+1]);
+                        t2 = LOAD(A[i1][j+2]);
+                        t3 = LOAD(A[i1][j+3]);
                     
-                        B[j][i1]  = t0;
-                        B[j+1][i1]= t1;
-                        B[j+2][i1]= t2;
-                        B[j+3][i1]= t3;
+                        STORE(B[j][i1], t0);
+                        STORE(B[j+1][i1], t1);
+                        STORE(B[j+2][i1], t2);
+                        STORE(B[j+3][i1], t3);
                 }
                 for (i1 = i+7; i1 > i-1; i1=i1-1) {
-                        t0= A[i1][j+4];
-                        t1= A[i1][j+5];
-                        t2= A[i1][j+6];
-                        t3= A[i1][j+7];
+                        t0 = LOAD(A[i1][j+4]);
+                        t1 = LOAD(A[i1][j+5]);
+                        t2 = LOAD(A[i1][j+6]);
+                        t3 = LOAD(A[i1][j+7]);
                     
-                        B[j+4][i1]= t0;
-                        B[j+5][i1]= t1;
-                        B[j+6][i1]= t2;
-                        B[j+7][i1]= t3;
+                        STORE(B[j+4][i1], t0);
+                        STORE(B[j+5][i1], t1);
+                        STORE(B[j+6][i1], t2);
+                        STORE(B[j+7][i1], t3);
                 }
             }
         }    
@@ -119,7 +124,7 @@ void transpose_submit(int M, int N, int A[N][M], int B[M][N])
             for (j = 0; j < M; j=j+8) {
                 for (j1 = j; (j1 < j+8) && (j1 < M); j1++){
                     for (i1 = i; (i1 < i+8) && (i1 < N); i1++){
-                        B[j1][i1] = A[i1][j1];
+                        STORE(B[j1][i1], LOAD(A[i1][j1]));
                     }
                 }
             }
@@ -148,8 +153,8 @@ void trans(int M, int N, int A[N][M], int B[M][N])
 
     for (i = 0; i < N; i++) {
         for (j = 0; j < M; j++) {
-            tmp = A[i][j];
-            B[j][i] = tmp;
+            tmp = LOAD(A[i][j]);
+            STORE(B[j][i], tmp);
         }
     }    
 
@@ -0,0 +1,231 @@
+/******************************************************
+ * Name - Sudhir Kumar Vijay
+ * Andrew ID - svijay
+ *
+ * DESCRIPTION:
+ * In-process evaluation of the transpose functions of
+ * trans.c, without valgrind or trace files. Each
+ * registered function runs once per matrix size with
+ * its LOAD and STORE accesses recorded (see recorder.h),
+ * and the recording is simulated on every cache of the
+ * -s, -E and -b lists, which default to the 1KB direct
+ * mapped cache with 32 byte blocks of the assignment,
+ * through the library of libcsim.h.
+ * The matrices are static arrays like in the trace
+ * generator of the assignment, so the conflicts between
+ * A and B are the same. Build with 'make trans_sim'.
+ ********************************************************/
+
+/* clock_gettime isn't part of C99 */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "cachelab.h"
+#include "recorder.h"
+#include "libcsim.h"
+
+/* Largest matrix dimension */
+#define MATRIX_MAX 256
+
+/* Most values in each of the -s, -E and -b lists */
+#define LIST_MAX 16
+
+static int A[MATRIX_MAX][MATRIX_MAX];
+static int B[MATRIX_MAX][MATRIX_MAX];
+
+static trans_func_t functions[MAX_TRANS_FUNCS];
+static int function_count = 0;
+
+void registerFunctions(void);
+int is_transpose(int M, int N, int A[N][M], int B[M][N]);
+
+/* Function - registerTransFunction
+ * Adding a transpose function to the list to evaluate, as
+ * registerFunctions in trans.c does for each of them.
+ * */
+void registerTransFunction(void (*trans)(int M, int N, int[N][M],
+                                         int[M][N]),
+                           char *desc){
+    if (function_count == MAX_TRANS_FUNCS)
+        return;
+    functions[function_count].func_ptr = trans;
+    functions[function_count].description = desc;
+    function_count++;
+}
+
+/* Function - parse_list
+ * Reading a comma separated list of up to LIST_MAX numbers
+ * in [low, high].
+ * ---------------------------------------------------
+ * Return value:
+ * Number of values, -1 for a malformed list.
+ * --------------------------------------------------
+ * */
+static int parse_list(const char *text, int *values, int low, int high){
+    char *end;
+    int count = 0;
+
+    do {
+        if (count == LIST_MAX)
+            return -1;
+        values[count] = (int)strtol(text, &end, 10);
+        if (end == text || values[count] < low || values[count] > high)
+            return -1;
+        count++;
+        text = end + 1;
+    } while (*end == ',');
+    return *end == '\0' ? count : -1;
+}
+
+/* Function - milliseconds
+ * Monotonic time in milliseconds.
+ * */
+static double milliseconds(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e3 + now.tv_nsec * 1e-6;
+}
+
+/* Function - usage
+ * Printing the options and exiting.
+ * */
+static void usage(void){
+    printf("Usage: ./trans_sim [-s <s>,...] [-E <E>,...] [-b <b>,...] "
+           "[-r <policy>] [-M <M> -N <N>]\n");
+    exit(1);
+}
+
+/* Function - evaluate
+ * Recording one transpose function on an M x N matrix and
+ * simulating the recording on every cache of the lists.
+ * ---------------------------------------------------
+ * Input parameters:
+ * Function, matrix size, the lists, the config to fill in
+ * and the recorder to use.
+ * --------------------------------------------------
+ * Return value:
+ * 0, or -1 if a cache or the recording ran out of memory.
+ * --------------------------------------------------
+ * */
+static int evaluate(trans_func_t *function, int M, int N,
+                    int *set_bits, int s_count, int *lines, int e_count,
+                    int *block_bits, int b_count,
+                    struct csim_config *config, struct recorder *recorder){
+    struct csim sim;
+    struct csim_stats stats;
+    double start = milliseconds();
+    double recorded;
+    int i, j, k;
+
+    for (i = 0; i < N; i++) {
+        for (j = 0; j < M; j++)
+            ((int (*)[M])A)[i][j] = i*M + j;
+    }
+    memset(B, 0, sizeof(B));
+    recorder_reset(recorder);
+    recorder_active = recorder;
+    function->func_ptr(M, N, (int (*)[M])A, (int (*)[N])B);
+    recorder_active = NULL;
+    function->correct = is_transpose(M, N, (int (*)[M])A, (int (*)[N])B);
+    recorded = milliseconds() - start;
+
+    for (i = 0; i < s_count; i++) {
+        for (j = 0; j < e_count; j++) {
+            for (k = 0; k < b_count; k++) {
+                start = milliseconds();
+                config->set_bits = set_bits[i];
+                config->number_of_lines = lines[j];
+                config->block_bits = block_bits[k];
+                if (recorder->failed || csim_init(&sim, config) < 0)
+                    return -1;
+                csim_access_batch(&sim, recorder->accesses,
+                                  (int)recorder->count);
+                csim_get_stats(&sim, &stats);
+                printf("%-24.24s %3dx%-3d %2d %3d %2d %9lu %9lu %9lu %9lu "
+                       "%s %8.2f\n", function->description, M, N,
+                       set_bits[i], lines[j], block_bits[k],
+                       recorder->count, stats.counts.hit_count,
+                       stats.counts.miss_count, stats.counts.eviction_count,
+                       function->correct ? "yes" : "NO ",
+                       recorded + milliseconds() - start);
+                csim_free(&sim);
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+    // The cache and matrix sizes of the assignment.
+    int set_bits[LIST_MAX] = {5};
+    int lines[LIST_MAX] = {1};
+    int block_bits[LIST_MAX] = {5};
+    int s_count = 1, e_count = 1, b_count = 1;
+    int sizes[][2] = {{32, 32}, {64, 64}, {61, 67}};
+    int size_count = 3;
+    struct csim_config config;
+    struct recorder recorder;
+    int opt;
+    int f, k;
+
+    csim_config_default(&config);
+    while ((opt = getopt(argc, argv, "s:E:b:r:M:N:")) != -1) {
+        switch(opt) {
+            case 's':
+                s_count = parse_list(optarg, set_bits, 0, 30);
+                break;
+            case 'E':
+                e_count = parse_list(optarg, lines, 1, 1 << 16);
+                break;
+            case 'b':
+                b_count = parse_list(optarg, block_bits, 0, 30);
+                break;
+            case 'r':
+                config.policy = replacement_find(optarg);
+                break;
+            case 'M':
+                sizes[0][0] = atoi(optarg);
+                size_count = 1;
+                break;
+            case 'N':
+                sizes[0][1] = atoi(optarg);
+                size_count = 1;
+                break;
+            default:
+                usage();
+        }
+    }
+    if (s_count < 0 || e_count < 0 || b_count < 0 || config.policy == NULL ||
+        sizes[0][0] < 1 || sizes[0][0] > MATRIX_MAX ||
+        sizes[0][1] < 1 || sizes[0][1] > MATRIX_MAX)
+        usage();
+    for (k = 0; k < e_count; k++) {
+        if (!replacement_supports(config.policy, lines[k])) {
+            printf("%s needs E to be a power of 2\n", config.policy->name);
+            exit(1);
+        }
+    }
+
+    registerFunctions();
+    recorder_init(&recorder);
+    printf("%-24s %7s %2s %3s %2s %9s %9s %9s %9s %3s %8s\n", "function",
+           "size", "s", "E", "b", "accesses", "hits", "misses",
+           "evictions", "ok", "ms");
+    for (f = 0; f < function_count; f++) {
+        for (k = 0; k < size_count; k++) {
+            if (evaluate(functions + f, sizes[k][0], sizes[k][1],
+                         set_bits, s_count, lines, e_count, block_bits,
+                         b_count, &config, &recorder) < 0) {
+                printf("Malloc error !");
+                exit(3);
+            }
+        }
+    }
+    recorder_free(&recorder);
+    return 0;
+}
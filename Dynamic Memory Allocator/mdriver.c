@@ -18,6 +18,9 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 
 #include "mm.h"
@@ -105,6 +108,8 @@ typedef struct {
 
     /* defined only for the student malloc package */
     double util;     /* space utilization for this trace (always 0 for libc) */
+    double dtlb_loads;  /* dTLB load accesses in one run, -1 if unknown (-T) */
+    double dtlb_misses; /* dTLB load misses in one run, -1 if unknown (-T) */
 
     /* Note: secs and util are only defined if valid is true */
 } stats_t;
@@ -137,6 +142,17 @@ int onetime_flag = 0;
 /* by default, no timeouts */
 static int set_timeout = 0;
 
+/* if set, measure utilization through the handle API (-H) */
+static int handle_mode = 0;
+
+/* if set, count dTLB load misses of one extra speed run (-T) */
+static int tlb_mode = 0;
+
+/* compaction budget the handle driver spends after every free: a fixed
+   slice plus a multiple of the bytes just freed */
+#define HANDLE_COMPACT_BUDGET 4096
+#define HANDLE_COMPACT_RATIO  8
+
 
 /* Directory where default tracefiles are found */
 static char tracedir[MAXLINE] = TRACEDIR;
@@ -177,8 +193,14 @@ static void eval_libc_speed(void *ptr);
    of the student's malloc package in mm.c */
 static int eval_mm_valid(trace_t *trace, range_t **ranges);
 static double eval_mm_util(trace_t *trace, int tracenum);
+static double eval_mm_handle_util(trace_t *trace, int tracenum);
 static void eval_mm_speed(void *ptr);
 
+/* Hardware counters for the dTLB report */
+static int eval_dtlb(void (*f)(void *), void *argp,
+                     double *loads, double *misses);
+static void printtlb(int n, stats_t *stats);
+
 /* Various helper routines */
 static void printresults(int n, stats_t *stats);
 static void usage(void);
@@ -235,12 +257,18 @@ static void run_tests(int num_tracefiles, const char *tracedir,
         if (mm_stats[i].valid) {
             if (verbose > 1)
                 printf("efficiency, ");
-            mm_stats[i].util = eval_mm_util(trace, i);
+            if (handle_mode)
+                mm_stats[i].util = eval_mm_handle_util(trace, i);
+            else
+                mm_stats[i].util = eval_mm_util(trace, i);
             speed_params->trace = trace;
             speed_params->ranges = ranges;
             if (verbose > 1)
                 printf("and performance.\n");
             mm_stats[i].secs = fsecs(eval_mm_speed, speed_params);
+            if (tlb_mode)
+                eval_dtlb(eval_mm_speed, speed_params,
+                          &mm_stats[i].dtlb_loads, &mm_stats[i].dtlb_misses);
         }
 
         free_trace(trace);
@@ -280,7 +308,7 @@ int main(int argc, char **argv)
     /*
      * Read and interpret the command line arguments
      */
-    while ((c = getopt(argc, argv, "d:f:c:s:t:v:hVAlD")) != EOF) {
+    while ((c = getopt(argc, argv, "d:f:c:s:t:v:hVAlDHT")) != EOF) {
         switch (c) {
 
         case 'A': /* Hidden Autolab driver argument */
@@ -338,6 +366,14 @@ int main(int argc, char **argv)
             set_timeout = atoi(optarg);
             break;
 
+        case 'H': /* Measure utilization with relocatable handles */
+            handle_mode = 1;
+            break;
+
+        case 'T': /* Report dTLB misses of the speed runs */
+            tlb_mode = 1;
+            break;
+
         case 'h': /* Print this message */
             usage();
             exit(0);
@@ -430,6 +466,11 @@ int main(int argc, char **argv)
             printf("\nResults for mm malloc:\n");
             printresults(num_tracefiles, mm_stats);
             printf("\n");
+            if (tlb_mode) {
+                printf("dTLB load misses for mm malloc:\n");
+                printtlb(num_tracefiles, mm_stats);
+                printf("\n");
+            }
         }
     }
 
@@ -977,10 +1018,9 @@ static int eval_mm_valid(trace_t *trace, range_t **ranges)
  *   The idea is to remember the high water mark "hwm" of the heap for
  *   an optimal allocator, i.e., no gaps and no internal fragmentation.
  *   Utilization is the ratio hwm/heapsize, where heapsize is the
- *   size of the heap in bytes after running the student's malloc
- *   package on the trace. Note that our implementation of mem_sbrk()
- *   doesn't allow the students to decrement the brk pointer, so brk
- *   is always the high water mark of the heap.
+ *   largest size the heap reached while running the student's malloc
+ *   package on the trace. mem_sbrk() lets the brk pointer be
+ *   decremented, so the high water mark is tracked by memlib.
  *
  *   A higher number is better: 1 is optimal.
  */
@@ -1065,7 +1105,118 @@ static double eval_mm_util(trace_t *trace, int tracenum)
 
     printf(".");
 
-    return ((double)max_total_size / (double)mem_heapsize());
+    return ((double)max_total_size / (double)mem_peak_heapsize());
+}
+
+/*
+ * eval_mm_handle_util - Same as eval_mm_util, but every block is
+ *   allocated through the handle API and left unpinned between
+ *   requests, so the compactor is free to move it. A slice of
+ *   compaction, paced by the size of the freed block, is run after
+ *   every free. Since blocks move behind our
+ *   back, each block is filled with a byte derived from its index and
+ *   checked when it is resized or freed.
+ */
+static double eval_mm_handle_util(trace_t *trace, int tracenum)
+{
+    int i, j;
+    int index;
+    int size, newsize, oldsize;
+    int max_total_size = 0;
+    int total_size = 0;
+    mm_handle_t *handles;
+    unsigned char *p;
+
+    if ((handles = calloc(trace->num_ids, sizeof(mm_handle_t))) == NULL)
+        unix_error("calloc failed in eval_mm_handle_util");
+
+    reinit_trace(trace);
+
+    /* initialize the heap and the mm malloc package */
+    mem_reset_brk();
+    if (mm_init() < 0)
+        app_error("trace %d: mm_init failed in eval_mm_handle_util", tracenum);
+
+    for (i = 0;  i < trace->num_ops;  i++) {
+        index = trace->ops[i].index;
+        switch (trace->ops[i].type) {
+
+        case ALLOC: /* mm_halloc */
+            size = trace->ops[i].size;
+            if ((handles[index] = mm_halloc(size)) == 0) {
+                app_error("trace %d: mm_halloc failed in eval_mm_handle_util",
+                          tracenum);
+            }
+            p = mm_hpin(handles[index]);
+            memset(p, index, size);
+            mm_hunpin(handles[index]);
+
+            trace->block_sizes[index] = size;
+            total_size += size;
+            break;
+
+        case REALLOC: /* mm_hrealloc */
+            newsize = trace->ops[i].size;
+            oldsize = trace->block_sizes[index];
+            if (newsize == 0) {
+                mm_hfree(handles[index]);
+                handles[index] = 0;
+            } else if (handles[index] == 0) {
+                if ((handles[index] = mm_halloc(newsize)) == 0)
+                    app_error("trace %d: mm_halloc failed in "
+                              "eval_mm_handle_util", tracenum);
+                oldsize = 0;
+            } else if (mm_hrealloc(handles[index], newsize) < 0) {
+                app_error("trace %d: mm_hrealloc failed in eval_mm_handle_util",
+                          tracenum);
+            }
+
+            if (handles[index] != 0) {
+                p = mm_hpin(handles[index]);
+                for (j = 0; j < oldsize && j < newsize; j++)
+                    if (p[j] != (unsigned char)index)
+                        app_error("trace %d: block %d garbled after "
+                                  "mm_hrealloc", tracenum, index);
+                if (newsize > oldsize)
+                    memset(p + oldsize, index, newsize - oldsize);
+                mm_hunpin(handles[index]);
+            }
+
+            trace->block_sizes[index] = newsize;
+            total_size += (newsize - oldsize);
+            break;
+
+        case FREE: /* mm_hfree */
+            if (index < 0 || handles[index] == 0)
+                break;
+            size = trace->block_sizes[index];
+            p = mm_hpin(handles[index]);
+            for (j = 0; j < size; j++)
+                if (p[j] != (unsigned char)index)
+                    app_error("trace %d: block %d garbled before mm_hfree",
+                              tracenum, index);
+            mm_hunpin(handles[index]);
+            mm_hfree(handles[index]);
+            handles[index] = 0;
+
+            mm_compact(HANDLE_COMPACT_BUDGET + HANDLE_COMPACT_RATIO * size);
+            total_size -= size;
+            break;
+
+        default:
+            app_error("trace %d: Nonexistent request type in "
+                      "eval_mm_handle_util", tracenum);
+        }
+
+        /* update the high-water mark */
+        max_total_size = (total_size > max_total_size) ?
+            total_size : max_total_size;
+    }
+
+    free(handles);
+    printf(".");
+
+    return ((double)max_total_size / (double)mem_peak_heapsize());
 }
 
 
@@ -1330,6 +1481,89 @@ static void printresults(int n, stats_t *stats)
 
 }
 
+/*
+ * perf_open - open a user-space hardware cache event counter
+ */
+static int perf_open(unsigned long long config, int group_fd)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+/*
+ * eval_dtlb - Run f(argp) once with the dTLB load access and miss
+ *     counters enabled. Returns 0 on success. If the miss counter
+ *     can't be opened (no PMU, perf_event_paranoid, ...) both counts
+ *     are set to -1 and -1 is returned; a missing access counter only
+ *     sets loads to -1.
+ */
+static int eval_dtlb(void (*f)(void *), void *argp,
+                     double *loads, double *misses)
+{
+    unsigned long long dtlb = PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8);
+    long long count;
+    int miss_fd, load_fd;
+
+    *loads = *misses = -1;
+    miss_fd = perf_open(dtlb | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), -1);
+    if (miss_fd < 0)
+        return -1;
+    load_fd = perf_open(dtlb | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16),
+                        miss_fd);
+
+    ioctl(miss_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(miss_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    f(argp);
+    ioctl(miss_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    if (read(miss_fd, &count, sizeof(count)) == sizeof(count))
+        *misses = count;
+    if (load_fd >= 0) {
+        if (read(load_fd, &count, sizeof(count)) == sizeof(count))
+            *loads = count;
+        close(load_fd);
+    }
+    close(miss_fd);
+    return 0;
+}
+
+/*
+ * printtlb - prints the dTLB misses recorded by -T for each trace
+ */
+static void printtlb(int n, stats_t *stats)
+{
+    int i;
+
+    printf("%12s%12s%8s%10s  %s\n",
+           "loads", "misses", "rate", "miss/Kop", "trace");
+    for (i = 0; i < n; i++) {
+        if (!stats[i].valid || stats[i].weight == WUTIL)
+            continue;
+        if (stats[i].dtlb_misses < 0) {
+            printf("%12s%12s%8s%10s  %s\n", "-", "-", "-", "-",
+                   stats[i].filename);
+            continue;
+        }
+        if (stats[i].dtlb_loads > 0)
+            printf("%12.0f%12.0f%7.3f%%", stats[i].dtlb_loads,
+                   stats[i].dtlb_misses,
+                   100.0 * stats[i].dtlb_misses / stats[i].dtlb_loads);
+        else
+            printf("%12s%12.0f%8s", "-", stats[i].dtlb_misses, "-");
+        printf("%10.2f  %s\n", stats[i].dtlb_misses * 1e3 / stats[i].ops,
+               stats[i].filename);
+    }
+}
+
 /*
  * app_error - Report an arbitrary application error
  */
@@ -1375,13 +1609,15 @@ void malloc_error(const trace_t *trace, int opnum, const char *fmt, ...)
  */
 static void usage(void)
 {
-    fprintf(stderr, "Usage: mdriver [-hlVdD] [-f <file>]\n");
+    fprintf(stderr, "Usage: mdriver [-hlVdDHT] [-f <file>]\n");
     fprintf(stderr, "Options\n");
     fprintf(stderr, "\t-d <i>     Debug: 0 off; 1 default; 2 lots.\n");
     fprintf(stderr, "\t-D         Equivalent to -d2.\n");
     fprintf(stderr, "\t-c <file>  Run trace file <file> once, check for correctness only.\n");
     fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
     fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-H         Measure utilization through the handle API.\n");
+    fprintf(stderr, "\t-T         Report dTLB load misses of the speed runs.\n");
     fprintf(stderr, "\t-l         Run libc malloc as well.\n");
     fprintf(stderr, "\t-V         Print diagnostics as each trace is run.\n");
     fprintf(stderr, "\t-v <i>     Set Verbosity Level to <i>\n");
@@ -12,35 +12,229 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <limits.h>
 
 #include "memlib.h"
 #include "config.h"
 
+#define HEAP_START ((char *)0x800000000)	/* suggested heap address */
+#define HUGEPAGE_SIZE (1UL<<21)				/* x86-64 transparent hugepage */
+#define HUGEPAGE_UP(p) \
+	((char *)(((unsigned long)(p) + HUGEPAGE_SIZE-1) & ~(HUGEPAGE_SIZE-1)))
+#define HEAP_MAGIC 0x3130706165486d6dUL	/* "mmHeap01" */
+
+/* First page of a heap file; the heap image follows on the next page */
+struct heap_file_header {
+	unsigned long magic;
+	unsigned long heap_lo;			/* heap address when it was saved */
+	unsigned long heapsize;			/* bytes of heap image in the file */
+};
+
 /* private variables */
 static char *heap;
 static char *mem_brk;
 static char *mem_max_addr;
+static char *mem_peak_brk;			/* high water mark of mem_brk */
+static char *mem_commit;			/* end of the read/write part of heap */
+static char *heap_map;				/* whole mapping, see mem_deinit */
+static size_t heap_map_size;
+
+/* file-backed heaps only */
+static long heap_delta;				/* heap - saved heap_lo */
+static char heap_path[PATH_MAX];	/* empty for anonymous heaps */
 
 /* 
- * mem_init - initialize the memory system model
+ * mem_init - initialize the memory system model. The heap is reserved
+ *		inaccessible and hugepage aligned, marked for transparent hugepages,
+ *		and made writable a hugepage at a time as it grows, so the kernel
+ *		can back every committed unit with a single 2MB page.
  */
 void mem_init(void){
 	int dev_zero = open("/dev/zero", O_RDWR);
-	heap = mmap((void *)0x800000000, /* suggested start*/
-			MAX_HEAP,				/* length */
-			PROT_WRITE,				/* permissions */
-			MAP_PRIVATE,			/* private or shared? */
+	heap_map_size = MAX_HEAP + HUGEPAGE_SIZE;	/* slack for alignment */
+	heap_map = mmap((void *)HEAP_START, /* suggested start*/
+			heap_map_size,			/* length */
+			PROT_NONE,				/* permissions */
+			MAP_PRIVATE | MAP_NORESERVE, /* private or shared? */
 			dev_zero,				/* fd */
 			0);						/* offset (dunno) */
+	close(dev_zero);
+	heap = HUGEPAGE_UP(heap_map);
+	madvise(heap, MAX_HEAP, MADV_HUGEPAGE);	/* best effort */
 	mem_max_addr = heap + MAX_HEAP;
 	mem_brk = heap;					/* heap is empty initially */
+	mem_peak_brk = heap;
+	mem_commit = heap;
+}
+
+/*
+ * mem_init_file - initialize the memory system model from a heap file.
+ *		The file is mapped copy-on-write right in front of the usual heap
+ *		address, so changes only reach it through mem_checkpoint and the
+ *		file always holds the last complete checkpoint. Returns 1 if a
+ *		saved heap was restored, 0 if the file was new or empty, and -1
+ *		on error.
+ */
+int mem_init_file(const char *path){
+	struct heap_file_header hdr;
+	size_t page = mem_pagesize();
+	int restored;
+	int fd;
+
+	if (strlen(path) >= sizeof(heap_path))
+		return -1;
+	if ((fd = open(path, O_RDWR | O_CREAT, 0600)) < 0)
+		return -1;
+
+	restored = (pread(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+			hdr.magic == HEAP_MAGIC && hdr.heapsize <= MAX_HEAP);
+	if (!restored)
+		memset(&hdr, 0, sizeof(hdr));
+
+	/* make the whole heap range backed by the (sparse) file */
+	if (ftruncate(fd, page + MAX_HEAP) < 0) {
+		close(fd);
+		return -1;
+	}
+	heap_map_size = page + MAX_HEAP;
+	heap_map = mmap(HEAP_START - page, heap_map_size, 
+			PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (heap_map == MAP_FAILED)
+		return -1;
+
+	strcpy(heap_path, path);
+	heap = heap_map + page;
+	mem_max_addr = heap + MAX_HEAP;
+	mem_brk = heap + hdr.heapsize;
+	mem_peak_brk = mem_brk;
+	mem_commit = mem_max_addr;		/* all of it is mapped read/write */
+	heap_delta = restored ? (long)(heap - (char *)hdr.heap_lo) : 0;
+	return restored && hdr.heapsize > 0;
+}
+
+/*
+ * write_all - pwrite the whole buffer, retrying short writes
+ */
+static int write_all(int fd, const void *buf, size_t len, off_t off){
+	ssize_t n;
+
+	while (len > 0) {
+		if ((n = pwrite(fd, buf, len, off)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf = (const char *)buf + n;
+		len -= n;
+		off += n;
+	}
+	return 0;
+}
+
+/*
+ * mem_checkpoint - durably save the heap of a file-backed memory system.
+ *		The image is written and fsync'd to "<path>.tmp", which is then
+ *		renamed over the heap file, and the directory is fsync'd. A crash
+ *		at any point leaves either the previous or the new checkpoint.
+ *		Returns 0 on success and -1 on error.
+ */
+int mem_checkpoint(void){
+	struct heap_file_header hdr;
+	char tmp_path[PATH_MAX + sizeof(".tmp")];
+	char *slash;
+	size_t page = mem_pagesize();
+	int fd;
+
+	if (heap_path[0] == '\0') {
+		errno = EINVAL;
+		return -1;
+	}
+
+	hdr.magic = HEAP_MAGIC;
+	hdr.heap_lo = (unsigned long)heap;
+	hdr.heapsize = mem_heapsize();
+
+	sprintf(tmp_path, "%s.tmp", heap_path);
+	if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0)
+		return -1;
+	if (write_all(fd, &hdr, sizeof(hdr), 0) < 0 ||
+			write_all(fd, heap, hdr.heapsize, page) < 0 ||
+			ftruncate(fd, page + MAX_HEAP) < 0 || fsync(fd) < 0) {
+		close(fd);
+		unlink(tmp_path);
+		return -1;
+	}
+	close(fd);
+	if (rename(tmp_path, heap_path) < 0) {
+		unlink(tmp_path);
+		return -1;
+	}
+
+	/* make the rename itself durable */
+	strcpy(tmp_path, heap_path);
+	if ((slash = strrchr(tmp_path, '/')) != NULL)
+		*(slash + 1) = '\0';
+	else
+		strcpy(tmp_path, ".");
+	if ((fd = open(tmp_path, O_RDONLY)) < 0)
+		return -1;
+	if (fsync(fd) < 0) {
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	return 0;
+}
+
+/*
+ * mem_heap_delta - how far the heap moved since it was checkpointed, for
+ *		fixing up absolute pointers after mem_init_file. Always 0 for
+ *		anonymous heaps.
+ */
+long mem_heap_delta(void){
+	return heap_delta;
 }
 
 /* 
  * mem_deinit - free the storage used by the memory system model
  */
 void mem_deinit(void){
-	munmap(heap, MAX_HEAP);
+	munmap(heap_map, heap_map_size);
+	heap_path[0] = '\0';
+	heap_delta = 0;
+}
+
+/*
+ * mem_commit_to - make the heap writable up to the hugepage boundary at
+ *		or above addr
+ */
+static int mem_commit_to(char *addr){
+	char *end = HUGEPAGE_UP(addr);
+
+	if (end > mem_max_addr)
+		end = mem_max_addr;
+	if (mprotect(mem_commit, end - mem_commit, PROT_READ | PROT_WRITE) < 0)
+		return -1;
+	mem_commit = end;
+	return 0;
+}
+
+/*
+ * mem_release - after the heap shrank, hand whole hugepages above the brk
+ *		back to the kernel. One spare hugepage is kept past the one
+ *		holding the brk, so a heap that shrinks and grows again around a
+ *		boundary doesn't keep faulting pages in. Partial hugepages are
+ *		never released, since that would keep them from being collapsed.
+ */
+static void mem_release(void){
+	char *keep = HUGEPAGE_UP(mem_brk) + HUGEPAGE_SIZE;
+
+	if (heap_path[0] != '\0' || mem_commit <= keep)
+		return;
+	madvise(keep, mem_commit - keep, MADV_DONTNEED);
+	mprotect(keep, mem_commit - keep, PROT_NONE);
+	mem_commit = keep;
 }
 
 /*
@@ -48,25 +242,41 @@ void mem_deinit(void){
  */
 void mem_reset_brk(){
 	mem_brk = heap;
+	mem_peak_brk = heap;
 }
 
 /* 
  * mem_sbrk - simple model of the sbrk function. Extends the heap 
- *		by incr bytes and returns the start address of the new area. In
- *		this model, the heap cannot be shrunk.
+ *		by incr bytes and returns the start address of the new area. A
+ *		negative incr gives the tail of the heap back; the process brk is
+ *		left alone in that case since libc may have moved it since.
  */
 void *mem_sbrk(int incr) {
 	char *old_brk = mem_brk;
 
+	if (incr < 0) {
+		if ((mem_brk + incr) < heap) {
+			errno = EINVAL;
+			fprintf(stderr, "ERROR: mem_sbrk failed. Shrunk past heap start...\n");
+			return (void *)-1;
+		}
+		mem_brk += incr;
+		mem_release();
+		return (void *)old_brk;
+	}
+
     // call sbrk() in an attempt to have similar semantics as a real allocator.
-	if ( (incr < 0) || ((mem_brk + incr) > mem_max_addr) ||
-            sbrk(incr) == (void *) -1) {
+	if (((mem_brk + incr) > mem_max_addr) || 
+			((mem_brk + incr) > mem_commit && mem_commit_to(mem_brk + incr) < 0) ||
+			sbrk(incr) == (void *) -1) {
 		errno = ENOMEM;
 		fprintf(stderr, "ERROR: mem_sbrk failed. Ran out of memory...\n");
 		return (void *)-1;
 	}
 
 	mem_brk += incr;
+	if (mem_brk > mem_peak_brk)
+		mem_peak_brk = mem_brk;
 	return (void *)old_brk;
 }
 
@@ -91,6 +301,14 @@ size_t mem_heapsize() {
 	return (size_t)((void *)mem_brk - (void *)heap);
 }
 
+/*
+ * mem_peak_heapsize() - returns the largest heap size seen since the last
+ *		reset, which is what a shrinking allocator should be charged for
+ */
+size_t mem_peak_heapsize() {
+	return (size_t)((void *)mem_peak_brk - (void *)heap);
+}
+
 /*
  * mem_pagesize() - returns the page size of the system
  */
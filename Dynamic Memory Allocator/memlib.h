@@ -1,11 +1,15 @@
 #include <unistd.h>
 
 void mem_init(void);               
+int mem_init_file(const char *path);
+int mem_checkpoint(void);
+long mem_heap_delta(void);
 void mem_deinit(void);
 void *mem_sbrk(int incr);
 void mem_reset_brk(void); 
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+size_t mem_peak_heapsize(void);
 size_t mem_pagesize(void);
 
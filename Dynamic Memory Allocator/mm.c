@@ -122,6 +122,42 @@
  * The offset is calculated by subtracting the heap_listp value from the actual
  * pointer value. This helps in improving utlization.
  * -----------------------------------------------------------------------------
+ * PERSISTENCE:
+ * The heap starts with the segregated list heads, and the remaining state 
+ * (handle table and root object, see 'struct mm_meta') sits in a block whose
+ * offset is kept in the prologue padding word, so all of the allocator state
+ * lives inside the heap. When memlib backs the heap with a file 
+ * ('mem_init_file'), a program can checkpoint it ('mem_checkpoint') and, after
+ * a restart, reopen the file and call 'mm_attach' instead of 'mm_init'.
+ * 'mm_get_root' then returns the object registered with 'mm_set_root'. Only
+ * the list heads hold absolute pointers; they are adjusted if the mapping 
+ * lands at a different address. A crash loses everything after the last 
+ * checkpoint, but never leaves a half-written heap behind.
+ * -----------------------------------------------------------------------------
+ * HANDLE AND COMPACTION POLICY:
+ * Blocks handed out by 'malloc' never move, so a heap that has been chopped up
+ * by frees stays fragmented. Callers that own every reference to their data
+ * can instead allocate through handles ('mm_halloc'), which lets the allocator
+ * relocate the block while nobody holds a pointer into it:
+ * ~ Handle table - An array of (offset, pin count) entries, itself allocated
+ * from the heap with 'malloc'. The offset is relative to heap_listp, exactly
+ * like the free list links. Unused entries are chained through the pin count
+ * field. Handle 'h' refers to entry h-1, so a handle of 0 means failure.
+ * ~ Handle block - An ordinary allocated block with bit-2 (HANDLE_BIT) of its
+ * header set. The first double word of the payload holds the handle number,
+ * so the compactor can find the table entry while walking the heap, and the
+ * caller's data starts right after it.
+ * ~ Pinning - 'mm_hpin' bumps the pin count and returns the data pointer,
+ * 'mm_hunpin' drops it. Only blocks with a zero pin count are moved.
+ * ~ Compaction - 'mm_compact' walks the heap from a saved cursor. Whenever a
+ * free block is directly followed by an unpinned handle block, the handle
+ * block is slid down into the free space and the hole it leaves is coalesced
+ * with whatever follows, so holes bubble up towards the end of the heap. The
+ * walk stops once the budget (bytes moved plus a double word per block
+ * visited) is spent and resumes there on the next call. Once the last block of
+ * the heap is free it is given back with a negative 'mem_sbrk'. 'malloc' runs
+ * a single slice before growing the heap whenever handles are live.
+ * -----------------------------------------------------------------------------
  */
 #include <assert.h>
 #include <stdio.h>
@@ -145,6 +181,7 @@
 #define free mm_free
 #define realloc mm_realloc
 #define calloc mm_calloc
+#define free_sized mm_free_sized
 #endif /* def DRIVER */
 
 /* single word (4) or double word (8) alignment */
@@ -171,6 +208,10 @@
 #define GET_ALLOC(p) (GET(p) & 0x1)
 #define GET_PREV_ALLOC(p) (GET(p) & 0x2)
 
+/* Header bit marking an allocated block that is owned by a handle */
+#define HANDLE_BIT 0x4
+#define GET_HANDLE(p) (GET(p) & HANDLE_BIT)
+
 /* Set/deset prev_alloc bit in the next block */
 #define HDRP_N_BLK(p) HDRP(NEXT_BLKP(p))
 #define SET_NEXT_ALLOC(p)   PUT(HDRP_N_BLK(p), (GET(HDRP_N_BLK(p)) | 0x2));
@@ -215,9 +256,30 @@
 /* Calculating the current size of the block */
 #define CURR_SIZE(bp) GET_SIZE(HDRP(bp))
 
+/* Block size needed for a request of 'size' bytes */
+#define ADJUSTED_SIZE(size) \
+    ((size) <= DSIZE ? 2*DSIZE : DSIZE * (((size) + DSIZE + WSIZE-1) / DSIZE))
+
+/* Growths in a row after which a block is treated as a growing buffer */
+#define GROWTH_STREAK 2
+
 /* Defining the number of size bins in the segregated bin */
 #define BIN_SIZE 7
 
+/* Initial number of entries in the handle table */
+#define HANDLE_TABLE_MIN 16
+
+/* Compaction work done by 'malloc' before it extends the heap */
+#define COMPACT_SLICE (1<<12)
+
+/* Given a handle, calculating its table entry and its block pointer */
+#define HANDLE_ENTRY(h) \
+    ((struct handle_entry *)(heap_listp + mm_meta->handle_table) + (h) - 1)
+#define HANDLE_BLKP(h)  (heap_listp + HANDLE_ENTRY(h)->offset)
+
+/* The prologue's alignment padding word holds the metadata block offset */
+#define META_OFFP (heap_listp - DSIZE)
+
 /* Global variables */
 static char *heap_listp = 0;  /* Pointer to first block */  
 
@@ -227,9 +289,33 @@ static char *heap_listp = 0;  /* Pointer to first block */
  */
 unsigned **seglist_head = NULL ;
 
+/* Entry of the handle table. 'pins' doubles as the next free entry number
+ * (0 ends the chain) while 'offset' is 0, i.e. while the entry is unused */
+struct handle_entry {
+    unsigned offset;   /* Block offset from heap_listp */
+    unsigned pins;     /* Number of outstanding mm_hpin calls */
+};
+
+/* Allocator state that has to survive a restart of a file-backed heap. It is
+ * allocated from the heap the first time it is needed, and every pointer in 
+ * it is stored as an offset from heap_listp */
+struct mm_meta {
+    unsigned root;          /* Root object offset, 0 if none */
+    unsigned handle_table;  /* Handle table offset, 0 if none */
+    unsigned handle_cap;    /* Number of entries in the table */
+    unsigned handle_free;   /* First unused handle, 0 if none */
+    unsigned handle_live;   /* Number of live handle blocks */
+};
+
+static struct mm_meta *mm_meta = NULL;
+static char *compact_cursor = NULL;   /* Where the next compaction resumes */
+static char *realloc_last = NULL;     /* Block last grown by 'realloc' */
+static unsigned realloc_streak = 0;   /* How often in a row it was grown */
+
 /* Function prototypes for internal helper routines */
 static void *extend_heap(size_t words);
 static void place(void *bp, size_t asize);
+static void *place_far(void *bp, size_t asize);
 static void *find_fit(size_t asize);
 static void *coalesce(void *bp);
 static void check_heap_block(void *bp);
@@ -239,6 +325,13 @@ static void delete_from_list(void* bp);
 static void block_split (void* bp, int index);
 static int  get_seg_index(size_t blocksize);
 static void check_cycle (unsigned* head);
+static int  init_meta(void);
+static int  grow_handle_table(void);
+static void *slide_block(void *bp);
+static size_t compact_slice(size_t budget);
+static void trim_heap(void);
+static void *grow_block(void *bp, size_t asize);
+static void shrink_block(void *bp, size_t asize);
 
 #ifdef VERBOSE_CHECKHEAP
 static void print_free_block(void *bp); 
@@ -293,6 +386,9 @@ int mm_init(void) {
 
     heap_listp += (2*WSIZE);                
     SET_NEXT_ALLOC(heap_listp)
+    mm_meta = NULL;
+    compact_cursor = NULL;
+    realloc_last = NULL;
     
     /* Extend the empty heap with a free block of chunksize bytes */
     if (extend_heap(CHUNKSIZE/WSIZE) == NULL) 
@@ -300,6 +396,80 @@ int mm_init(void) {
     return 0;
 }
 
+/* ----------------------------------------------------------------------------
+ * Function: mm_attach
+ * Input parameters: -none-
+ * Return parameters: 0 on success, -1 on error.
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_attach' takes over a heap that memlib restored from a file (see 
+ * 'mem_init_file'), instead of building an empty one like 'mm_init'. The heap
+ * layout is fixed, so 'heap_listp' and 'seglist_head' are found at their usual
+ * places, and the metadata block through the prologue padding word. 
+ * Everything in the heap is stored as an offset from heap_listp except the 
+ * segregated list heads, which are moved by the amount the mapping moved since
+ * the checkpoint. Handle pins are dropped, since the pointers they protected
+ * are gone. An empty heap is simply initialized.
+ * ----------------------------------------------------------------------------
+ */
+int mm_attach(void) {
+    char *lo = mem_heap_lo();
+    long delta = mem_heap_delta();
+    mm_handle_t h;
+    int i;
+
+    if (mem_heapsize() == 0)
+        return mm_init();
+
+    seglist_head = (unsigned **) lo;
+    heap_listp = lo + BIN_SIZE*DSIZE + 2*WSIZE;
+    mm_meta = GET(META_OFFP) ? (struct mm_meta *)(heap_listp + GET(META_OFFP))
+                             : NULL;
+    compact_cursor = NULL;
+    realloc_last = NULL;
+
+    for (i = 0; i <= (BIN_SIZE-1); i++) {
+        if (seglist_head[i] != NULL)
+            seglist_head[i] = (unsigned *)((char *)seglist_head[i] + delta);
+    }
+
+    /* Pointers from 'mm_hpin' died with the process that took them, so no
+     * block is pinned any more. Unused entries keep their chain links. */
+    if (mm_meta != NULL && mm_meta->handle_table != 0) {
+        for (h = 1; h <= mm_meta->handle_cap; h++) {
+            if (HANDLE_ENTRY(h)->offset != 0)
+                HANDLE_ENTRY(h)->pins = 0;
+        }
+    }
+    #ifdef DEBUG            
+        mm_checkheap(__LINE__);
+    #endif   
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: mm_set_root / mm_get_root
+ * Input parameters: Pointer to the root object (mm_set_root).
+ * Return parameters: Pointer to the root object (mm_get_root), NULL if none.
+ * ----------------------------------------------------------------------------
+ * Description:
+ * The root is the one pointer a program needs to find its data again after
+ * reopening a file-backed heap. It is stored as an offset in the heap 
+ * metadata, so it follows the heap when the mapping moves. NULL clears it.
+ * ----------------------------------------------------------------------------
+ */
+void mm_set_root(void *p) {
+    if (init_meta() < 0)
+        return;
+    mm_meta->root = (p == NULL) ? 0 : P_OFFSET_VAL(p);
+}
+
+void *mm_get_root(void) {
+    if (heap_listp == 0 || mm_meta == NULL || mm_meta->root == 0)
+        return NULL;
+    return heap_listp + mm_meta->root;
+}
+
 /* ----------------------------------------------------------------------------
  * Function: malloc
  * Input parameters: size of block to be allocated.
@@ -318,8 +488,10 @@ int mm_init(void) {
  * Once the size of the block is found out, 'malloc' then searches the entire 
  * free list for a block and if found, malloc returns the pointer of the free 
  * block after placement (by calling the 'place' function). If no block is 
- * found, then 'malloc' calls the 'extend_heap' function to extend the heap.
- * If 'extend_heap' fails to allot a new heap, then NULL is returned.
+ * found and handle blocks are live, one compaction slice is run and the search
+ * is retried. Failing that, 'malloc' calls the 'extend_heap' function to 
+ * extend the heap. If 'extend_heap' fails to allot a new heap, then NULL is 
+ * returned.
  * ----------------------------------------------------------------------------
  */
 void *malloc (size_t size) {
@@ -337,24 +509,28 @@ void *malloc (size_t size) {
         return NULL;
 
     /* Calculating the adjested size */
-    if (size <= 1*DSIZE)                                          
-        asize = (2*DSIZE);                            
-    else
-        asize = DSIZE * ((size + (DSIZE) + (WSIZE-1)) / DSIZE); 
+    asize = ADJUSTED_SIZE(size);
 
     /* Search the free list for a fit */
     if ((bp = find_fit(asize)) != NULL) {  
-        place(bp, asize);     
+        bp = place_far(bp, asize);
         #ifdef DEBUG            
             mm_checkheap(__LINE__);
         #endif
         return bp;
     }
 
+    /* Squeeze out holes between relocatable blocks before growing */
+    if (mm_meta != NULL && mm_meta->handle_live > 0 && 
+        compact_slice(MAX(asize, COMPACT_SLICE)) > 0 &&
+        (bp = find_fit(asize)) != NULL) {
+        return place_far(bp, asize);
+    }
+
     extendsize = MAX(asize,CHUNKSIZE);               
     if ((bp = extend_heap(extendsize/WSIZE)) == NULL)  
         return NULL;         
-    place(bp, asize);
+    bp = place_far(bp, asize);
     #ifdef DEBUG            
             mm_checkheap(__LINE__);
     #endif   
@@ -389,6 +565,9 @@ void free (void *bp) {
         mm_init();
     }
 
+    if (bp == realloc_last)
+        realloc_last = NULL;
+
     /* Preserving the previous_alloc bits */
     PUT(HDRP(bp), PACK(size, GET_PREV_ALLOC(HDRP(bp))));
     PUT(FTRP(bp), PACK(size, 0));
@@ -396,6 +575,30 @@ void free (void *bp) {
     coalesce(bp);
 }
 
+/* ----------------------------------------------------------------------------
+ * Function: free_sized
+ * Input parameters: Pointer to block and the size it was allocated with.
+ * Return parameters: -none-
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'free_sized' is 'free' for callers that know the size of the block, like
+ * C++ sized deallocation. The header already holds the block size, so the
+ * size is only used to catch mismatched frees when DEBUG is enabled.
+ * ----------------------------------------------------------------------------
+ */
+void free_sized (void *bp, size_t size) {
+    #ifdef DEBUG
+        if (bp != 0 && size + WSIZE > GET_SIZE(HDRP(bp))) {
+            printf("%s Error: %zu bytes freed from a %u byte block\n", 
+                   __func__, size, GET_SIZE(HDRP(bp)));
+            exit(-1);
+        }
+    #else
+        (void)size;
+    #endif
+    free(bp);
+}
+
 /* ----------------------------------------------------------------------------
  * Function: realloc
  * Input parameters: Pointer to allocated block and size to be reallocated.
@@ -408,13 +611,24 @@ void free (void *bp) {
  * since that's the equivalent of a zero size block. Similarly, in the case 
  * that a null pointer is provided, the 'realloc' function calls the 'malloc' 
  * function to allocate a block of input size. 
+ * A block is resized in place whenever possible: a shrinking block gives its
+ * tail back, and a growing block absorbs the free block after it or, if it is
+ * the last block in the heap, grows with the heap (see 'grow_block'). Only 
+ * otherwise is the data moved, and then:
+ * ~ If the block being moved is the one that was grown last, it is probably a
+ * buffer that keeps growing, so a free block of twice the new size is looked
+ * for. The block is placed at its start and the rest stays free right after 
+ * it, for the next growth to absorb. Other requests may still use it, but 
+ * 'place_far' carves them from its far end. The heap is never extended just 
+ * for this headroom.
  * If the realloc fails, then no change is made to the original block and a 
  * NULL pointer is returned.
  * ----------------------------------------------------------------------------
  */
  void *realloc(void *ptr, size_t size) {
     size_t oldsize;
-    void *newptr;
+    size_t asize;
+    char *newptr = NULL;
 
     /* If size == 0 then this is just free, and we return NULL. */
     if(size == 0) {
@@ -427,20 +641,34 @@ void free (void *bp) {
         return mm_malloc(size);
     }
 
-    newptr = mm_malloc(size);
+    asize = ADJUSTED_SIZE(size);
+    oldsize = CURR_SIZE(ptr);
+    if (asize <= oldsize) {
+        shrink_block(ptr, asize);
+        return ptr;
+    }
+    realloc_streak = (ptr == realloc_last) ? realloc_streak + 1 : 1;
+    if (grow_block(ptr, asize) != NULL) {
+        realloc_last = ptr;
+        return ptr;
+    }
+
+    /* Reserving headroom for a block that keeps growing */
+    if (realloc_streak >= GROWTH_STREAK && 
+        (newptr = find_fit(2*asize)) != NULL)
+        place(newptr, asize);
 
-    /* If realloc() fails the original block is left untouched  */
-    if(!newptr) {
+    if (newptr == NULL && (newptr = mm_malloc(size)) == NULL) {
+        /* If realloc() fails the original block is left untouched  */
         return 0;
     }
 
     /* Copy the old data into new block */
-    oldsize = GET_SIZE(HDRP(ptr));
-    if(size < oldsize) oldsize = size;
-    memcpy(newptr, ptr, oldsize);
+    memcpy(newptr, ptr, oldsize - WSIZE);
 
     /* Free the old block. */
     mm_free(ptr);
+    realloc_last = newptr;
     return newptr;
 }
 
@@ -471,6 +699,149 @@ void *calloc (size_t num_blocks, size_t size) {
   return ptr;
 }
 
+/* ----------------------------------------------------------------------------
+ * Function: mm_halloc
+ * Input parameters: size of block to be allocated.
+ * Return parameters: Handle of the allocated block, 0 on failure.
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_halloc' allocates a relocatable block. The block is a regular 'malloc'
+ * block with room for the handle number in front of the caller's data, and
+ * with the HANDLE_BIT set in its header so that the compactor may move it.
+ * The handle table is grown (doubling) when it has no unused entries left.
+ * The new block is unpinned; 'mm_hpin' has to be called before it is used.
+ * ----------------------------------------------------------------------------
+ */
+mm_handle_t mm_halloc(size_t size) {
+    char *bp;
+    mm_handle_t h;
+
+    if (size == 0 || init_meta() < 0)
+        return 0;
+    if (mm_meta->handle_free == 0 && grow_handle_table() < 0)
+        return 0;
+    if ((bp = malloc(size + DSIZE)) == NULL)
+        return 0;
+
+    /* Taking the first unused entry off the chain */
+    h = mm_meta->handle_free;
+    mm_meta->handle_free = HANDLE_ENTRY(h)->pins;
+    HANDLE_ENTRY(h)->offset = P_OFFSET_VAL(bp);
+    HANDLE_ENTRY(h)->pins = 0;
+    mm_meta->handle_live++;
+
+    PUT(HDRP(bp), GET(HDRP(bp)) | HANDLE_BIT);
+    PUT(bp, h);
+    return h;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: mm_hfree
+ * Input parameters: Handle of the block.
+ * Return parameters: -none-
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_hfree' frees the block owned by the handle and puts the table entry back
+ * on the unused chain. A zero handle is ignored, like a NULL pointer in 'free'.
+ * ----------------------------------------------------------------------------
+ */
+void mm_hfree(mm_handle_t h) {
+    if (h == 0)
+        return;
+
+    free(HANDLE_BLKP(h));
+    HANDLE_ENTRY(h)->offset = 0;
+    HANDLE_ENTRY(h)->pins = mm_meta->handle_free;
+    mm_meta->handle_free = h;
+    mm_meta->handle_live--;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: mm_hrealloc
+ * Input parameters: Handle of the block and the new size.
+ * Return parameters: 0 on success, -1 if the block could not be resized.
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_hrealloc' resizes the block owned by the handle, keeping the handle
+ * itself valid. The block is pinned across the 'realloc' call, because the
+ * 'malloc' inside it may run the compactor while the old data is still needed.
+ * Pointers obtained from 'mm_hpin' before the call are stale afterwards. On
+ * failure the old block is left untouched.
+ * ----------------------------------------------------------------------------
+ */
+int mm_hrealloc(mm_handle_t h, size_t size) {
+    char *bp;
+
+    if (h == 0 || size == 0)
+        return -1;
+
+    HANDLE_ENTRY(h)->pins++;
+    bp = realloc(HANDLE_BLKP(h), size + DSIZE);
+    HANDLE_ENTRY(h)->pins--;
+    if (bp == NULL)
+        return -1;
+
+    /* The handle number was copied over along with the data */
+    PUT(HDRP(bp), GET(HDRP(bp)) | HANDLE_BIT);
+    HANDLE_ENTRY(h)->offset = P_OFFSET_VAL(bp);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: mm_hpin
+ * Input parameters: Handle of the block.
+ * Return parameters: Pointer to the data of the block.
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_hpin' keeps the block from being moved until the matching 'mm_hunpin'
+ * and returns a pointer to its data. Pins nest.
+ * ----------------------------------------------------------------------------
+ */
+void *mm_hpin(mm_handle_t h) {
+    HANDLE_ENTRY(h)->pins++;
+    return HANDLE_BLKP(h) + DSIZE;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: mm_hunpin
+ * Input parameters: Handle of the block.
+ * Return parameters: -none-
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_hunpin' drops one pin. Once no pins are left, pointers returned by
+ * 'mm_hpin' must no longer be used.
+ * ----------------------------------------------------------------------------
+ */
+void mm_hunpin(mm_handle_t h) {
+    HANDLE_ENTRY(h)->pins--;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: mm_compact
+ * Input parameters: Work budget for this call.
+ * Return parameters: Number of bytes moved.
+ * ----------------------------------------------------------------------------
+ * Description:
+ * 'mm_compact' runs one bounded compaction slice (see 'compact_slice') and
+ * then returns a free block at the very end of the heap to the memory system.
+ * Calling it repeatedly with a small budget spreads the work of a full pass
+ * over many calls.
+ * ----------------------------------------------------------------------------
+ */
+size_t mm_compact(size_t budget) {
+    size_t moved;
+
+    if (heap_listp == 0)
+        return 0;
+
+    moved = (mm_meta && mm_meta->handle_live > 0) ? compact_slice(budget) : 0;
+    trim_heap();
+    #ifdef DEBUG            
+        mm_checkheap(__LINE__);
+    #endif   
+    return moved;
+}
+
 /* --- HELPER FUNCTIONS --- */
 
 /* ----------------------------------------------------------------------------
@@ -579,6 +950,9 @@ static void *coalesce(void *bp)
         add_to_list(PRED(bp));    
         SET_NEXT_DEALLOC(PRED(bp));
     }
+    /* Keep the compaction cursor on a block boundary */
+    if (compact_cursor > (char *)bp && compact_cursor < (char *)bp + size)
+        compact_cursor = bp;
     #ifdef DEBUG            
             mm_checkheap(__LINE__);
     #endif   
@@ -869,6 +1243,47 @@ static void place(void *bp, size_t asize)
     }
 }
 
+/* ----------------------------------------------------------------------------
+ * Function: place_far
+ * Input parameters: Block pointer of the free block to be used and size of 
+ *                   new allocated block.
+ * Return parameters: Pointer to the allocated block.
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * 'place' for 'malloc'. If the free block lies right after the block that 
+ * 'realloc' grew last, the request is carved from the far end of the free 
+ * block instead of its start, so the space next to the growing block stays 
+ * free for it. The free block keeps its address, so it only changes lists if
+ * it moves to a different bin.
+ * ----------------------------------------------------------------------------
+ */
+static void *place_far(void *bp, size_t asize)
+{
+    size_t csize = GET_SIZE(HDRP(bp));
+    size_t fsize = csize - asize;
+    int relist;
+    char *abp;
+
+    if (realloc_last == NULL || realloc_streak < GROWTH_STREAK || 
+        NEXT_BLKP(realloc_last) != bp || fsize < 2*DSIZE) {
+        place(bp, asize);
+        return bp;
+    }
+
+    relist = (get_seg_index(fsize) != get_seg_index(csize));
+    if (relist)
+        delete_from_list(bp);
+    PUT(HDRP(bp), PACK(fsize, GET_PREV_ALLOC(HDRP(bp))));
+    PUT(FTRP(bp), PACK(fsize, 0));
+    if (relist)
+        add_to_list(bp);
+
+    abp = NEXT_BLKP(bp);
+    PUT(HDRP(abp), PACK(asize, 0x1));
+    SET_NEXT_ALLOC(abp);
+    return abp;
+}
+
 /* ----------------------------------------------------------------------------
  * Function: find_fit
  * Input parameters: Size of the block to be found.
@@ -909,6 +1324,229 @@ static void *find_fit(size_t asize)
     return NULL; /* No fit */
 }
 
+/* ----------------------------------------------------------------------------
+ * Function: init_meta
+ * Input parameters: -none-
+ * Return parameters: 0 on success, -1 if the metadata could not be allocated.
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * Allocates the zeroed metadata block on first use and records its offset in
+ * the prologue padding word, so heaps that never use handles or a root object
+ * pay nothing for it.
+ * ----------------------------------------------------------------------------
+ */
+static int init_meta(void) {
+    struct mm_meta *meta;
+
+    if (mm_meta != NULL)
+        return 0;
+    if ((meta = malloc(sizeof(struct mm_meta))) == NULL)
+        return -1;
+    memset(meta, 0, sizeof(struct mm_meta));
+    PUT(META_OFFP, P_OFFSET_VAL(meta));
+    mm_meta = meta;
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: grow_handle_table
+ * Input parameters: -none-
+ * Return parameters: 0 on success, -1 if the table could not be grown.
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * Doubles the handle table (starting at HANDLE_TABLE_MIN entries) and chains
+ * the new entries in front of the unused list. The table is a plain 'malloc'
+ * block, so it is never moved by the compactor.
+ * ----------------------------------------------------------------------------
+ */
+static int grow_handle_table(void) {
+    struct handle_entry *table = NULL;
+    unsigned cap = mm_meta->handle_cap;
+    unsigned new_cap = cap ? 2*cap : HANDLE_TABLE_MIN;
+    unsigned i;
+
+    if (cap > 0)
+        table = (struct handle_entry *)(heap_listp + mm_meta->handle_table);
+    table = realloc(table, new_cap * sizeof(struct handle_entry));
+    if (table == NULL)
+        return -1;
+
+    for (i = cap; i < new_cap; i++) {
+        table[i].offset = 0;
+        table[i].pins = (i+1 < new_cap) ? i+2 : mm_meta->handle_free;
+    }
+    mm_meta->handle_free = cap + 1;
+    mm_meta->handle_table = P_OFFSET_VAL(table);
+    mm_meta->handle_cap = new_cap;
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: slide_block
+ * Input parameters: Pointer to a free block followed by a handle block.
+ * Return parameters: Pointer to the free block left behind.
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * Swaps a free block with the unpinned handle block right after it. The data
+ * is moved down to the start of the free block, a free block of the old size 
+ * is written after it, and that block is coalesced with its next neighbour.
+ * The previous block is always allocated here, since the heap is coalesced.
+ * ----------------------------------------------------------------------------
+ */
+static void *slide_block(void *bp) {
+    char *abp = NEXT_BLKP(bp);
+    size_t fsize = CURR_SIZE(bp);
+    size_t asize = CURR_SIZE(abp);
+    size_t prev_alloc = GET_PREV_ALLOC(HDRP(bp));
+    mm_handle_t h = GET(abp);
+    char *fbp;
+
+    delete_from_list(bp);
+    memmove(bp, abp, asize - WSIZE);
+    PUT(HDRP(bp), PACK(asize, prev_alloc | 0x1 | HANDLE_BIT));
+    HANDLE_ENTRY(h)->offset = P_OFFSET_VAL(bp);
+    if (abp == realloc_last)
+        realloc_last = bp;
+
+    fbp = NEXT_BLKP(bp);
+    PUT(HDRP(fbp), PACK(fsize, 0x2));
+    PUT(FTRP(fbp), PACK(fsize, 0));
+    return coalesce(fbp);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: compact_slice
+ * Input parameters: Work budget.
+ * Return parameters: Number of bytes moved.
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * Walks the heap from 'compact_cursor', sliding every unpinned handle block 
+ * that follows a free block down into it. A block that 'realloc' is growing
+ * is neither moved nor has its headroom filled. Each block visited costs a 
+ * double word of the budget and each block moved costs its size. The cursor is left
+ * where the walk stopped, or reset to the start of the heap when the walk 
+ * reached the epilogue.
+ * ----------------------------------------------------------------------------
+ */
+static size_t compact_slice(size_t budget) {
+    char *bp = compact_cursor ? compact_cursor : NEXT_BLKP(heap_listp);
+    char *nbp;
+    size_t moved = 0;
+    size_t work = 0;
+
+    while (CURR_SIZE(bp) > 0 && work < budget) {
+        nbp = NEXT_BLKP(bp);
+        work += DSIZE;
+        /* A block 'realloc' keeps growing stays where it is, and so does
+         * the free block after it, its headroom (see 'place_far'): sliding
+         * either way would use up the room it grows into. */
+        if (!GET_ALLOC(HDRP(bp)) && GET_HANDLE(HDRP(nbp)) &&
+            HANDLE_ENTRY(GET(nbp))->pins == 0 &&
+            !(realloc_last != NULL && realloc_streak >= GROWTH_STREAK &&
+              (bp == NEXT_BLKP(realloc_last) || nbp == realloc_last))) {
+            moved += CURR_SIZE(nbp);
+            work += CURR_SIZE(nbp);
+            bp = slide_block(bp);
+        } else {
+            bp = nbp;
+        }
+    }
+    compact_cursor = (CURR_SIZE(bp) > 0) ? bp : NULL;
+    return moved;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: trim_heap
+ * Input parameters: -none-
+ * Return parameters: -none-
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * If the last block in the heap is free, it is taken off its free list, its
+ * header becomes the new epilogue and the heap is shrunk by its size.
+ * ----------------------------------------------------------------------------
+ */
+static void trim_heap(void) {
+    char *ep = (char *)mem_heap_hi() + 1; /* Epilogue block pointer */
+    char *bp;
+    size_t size;
+
+    if (GET_PREV_ALLOC(HDRP(ep)))
+        return;
+
+    bp = PREV_BLKP(ep);
+    size = CURR_SIZE(bp);
+    delete_from_list(bp);
+    PUT(HDRP(bp), PACK(0, GET_PREV_ALLOC(HDRP(bp)) | 0x1));
+    mem_sbrk(-(int)size);
+
+    if (compact_cursor >= bp)
+        compact_cursor = NULL;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: grow_block
+ * Input parameters: Pointer to allocated block and its new (adjusted) size.
+ * Return parameters: Pointer to the block, NULL if it cannot grow in place.
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * Grows an allocated block without moving it, by absorbing the free block 
+ * that follows it. When the block (or the free block after it) is the last 
+ * one in the heap, the heap is extended by just the shortfall (or the minimum
+ * free block size) first, so no sliver is left behind the block for small 
+ * requests to land in. Any space beyond 'asize' is given back by 
+ * 'shrink_block'.
+ * ----------------------------------------------------------------------------
+ */
+static void *grow_block(void *bp, size_t asize) {
+    size_t csize = CURR_SIZE(bp);
+    char *nbp = NEXT_BLKP(bp);
+    size_t nsize = CURR_SIZE(nbp);
+
+    if (GET_ALLOC(HDRP(nbp)) && nsize > 0)
+        return NULL;
+    if (csize + nsize < asize) {
+        /* Only the end of the heap can make up the difference */
+        if (nsize > 0 && CURR_SIZE(NEXT_BLKP(nbp)) > 0)
+            return NULL;
+        if (extend_heap(MAX(asize - csize - nsize, 2*DSIZE)/WSIZE) == NULL)
+            return NULL;
+        nsize = CURR_SIZE(nbp);
+    }
+
+    delete_from_list(nbp);
+    PUT(HDRP(bp), PACK(csize + nsize, GET(HDRP(bp)) & 0x7));
+    SET_NEXT_ALLOC(bp);
+    if (compact_cursor > (char *)bp && compact_cursor < NEXT_BLKP(bp))
+        compact_cursor = bp;
+    shrink_block(bp, asize);
+    return bp;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function: shrink_block
+ * Input parameters: Pointer to allocated block and its new (adjusted) size.
+ * Return parameters: -none-
+ * ----------------------------------------------------------------------------
+ * Description: 
+ * Cuts an allocated block down to 'asize' bytes, if what is left over makes a
+ * free block of at least 2*DSIZE. The left over block is coalesced with the 
+ * block after it.
+ * ----------------------------------------------------------------------------
+ */
+static void shrink_block(void *bp, size_t asize) {
+    size_t csize = CURR_SIZE(bp);
+    char *fbp;
+
+    if (csize - asize < 2*DSIZE)
+        return;
+
+    PUT(HDRP(bp), PACK(asize, GET(HDRP(bp)) & 0x7));
+    fbp = NEXT_BLKP(bp);
+    PUT(HDRP(fbp), PACK(csize - asize, 0x2));
+    PUT(FTRP(fbp), PACK(csize - asize, 0));
+    coalesce(fbp);
+}
+
 /* DEBUG FUNCTIONS */
 
 /* ----------------------------------------------------------------------------
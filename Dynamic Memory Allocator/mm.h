@@ -7,6 +7,7 @@ extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
 extern void *mm_calloc (size_t nmemb, size_t size);
+extern void mm_free_sized (void *ptr, size_t size);
 
 #else
 
@@ -15,11 +16,29 @@ extern void *malloc (size_t size);
 extern void free (void *ptr);
 extern void *realloc(void *ptr, size_t size);
 extern void *calloc (size_t nmemb, size_t size);
+extern void free_sized (void *ptr, size_t size);
 
 #endif
 
 extern int mm_init(void);
 
+/* File-backed heaps: reattach after mem_init_file() restored a heap, and
+   record the object to be found again after a restart. */
+extern int mm_attach(void);
+extern void mm_set_root(void *p);
+extern void *mm_get_root(void);
+
+/* Relocatable allocations. A handle names a block that the compactor is
+   free to move while it is unpinned; pin it to get a stable pointer. */
+typedef unsigned mm_handle_t;
+
+extern mm_handle_t mm_halloc(size_t size);
+extern void mm_hfree(mm_handle_t h);
+extern int mm_hrealloc(mm_handle_t h, size_t size);
+extern void *mm_hpin(mm_handle_t h);
+extern void mm_hunpin(mm_handle_t h);
+extern size_t mm_compact(size_t budget);
+
 /* This is largely for debugging.  You can do what you want with the
    verbose flag; we don't care. */
 extern void mm_checkheap(int verbose);
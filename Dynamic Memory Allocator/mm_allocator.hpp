@@ -0,0 +1,169 @@
+/* -----------------------------------------------------------------------------
+ * File: mm_allocator.hpp
+ * Name: Sudhir Kumar Vijay
+ * Andrew ID: svijay@andrew.cmu.edu
+ * Private dependencies - mm.o (built with -DDRIVER) memlib.o
+ * -----------------------------------------------------------------------------
+ * Header-only C++ adapters for the segregated list allocator in mm.c, so that
+ * selected containers can be placed in the mm heap without replacing the
+ * global malloc:
+ * ~ mm::resource - A std::pmr::memory_resource for pmr containers. Requests
+ * are serialized with a std::mutex, since mm.c keeps a single global heap.
+ * ~ mm::unsynchronized_resource - The same without the lock, for programs
+ * that only touch the mm heap from one thread.
+ * ~ mm::allocator<T> - A standard Allocator for the classic containers, e.g.
+ * std::vector<int, mm::allocator<int>>. It goes through the process-wide
+ * mm::resource, so all instances compare equal.
+ *
+ * Deallocation always passes the size down to 'mm_free_sized'. mm.c only
+ * guarantees 8 byte alignment; larger alignments are served by over-allocating
+ * and keeping the original pointer in the word before the aligned one.
+ *
+ * The simulated heap (memlib) is initialized the first time a resource is
+ * constructed. mm.o has to be built with -DDRIVER, as for mdriver, so that
+ * the allocator is reached as mm_malloc and friends.
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef __MM_ALLOCATOR_HPP__
+#define __MM_ALLOCATOR_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+
+/* mm.h declares the mm_ names only for driver builds */
+#ifndef DRIVER
+#define DRIVER
+#endif
+
+extern "C" {
+#include "memlib.h"
+#include "mm.h"
+}
+
+namespace mm {
+
+/* Alignment that mm_malloc guarantees */
+constexpr std::size_t alignment = 8;
+
+/* Lock type for resources that are never shared between threads */
+struct null_lock {
+    void lock() {}
+    void unlock() {}
+};
+
+/* Sets up memlib and an empty mm heap, exactly once per process */
+inline void heap_init() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        mem_init();
+        if (mm_init() < 0)
+            throw std::bad_alloc();
+    });
+}
+
+/* ----------------------------------------------------------------------------
+ * Class: basic_resource
+ * ----------------------------------------------------------------------------
+ * Description:
+ * memory_resource backed by mm_malloc/mm_free_sized, with every call made
+ * under a lock of type 'Lock'. Over-aligned requests reserve 'align' extra
+ * bytes and record the pointer returned by mm_malloc just below the aligned
+ * address, where 'do_deallocate' finds it again.
+ * ----------------------------------------------------------------------------
+ */
+template <class Lock>
+class basic_resource : public std::pmr::memory_resource {
+public:
+    basic_resource() { heap_init(); }
+
+private:
+    Lock lock_;
+
+    void *do_allocate(std::size_t bytes, std::size_t align) override {
+        std::lock_guard<Lock> guard(lock_);
+        if (align <= alignment) {
+            void *p = mm_malloc(bytes ? bytes : 1);
+            if (p == nullptr)
+                throw std::bad_alloc();
+            return p;
+        }
+
+        char *raw = static_cast<char *>(mm_malloc(bytes + align));
+        if (raw == nullptr)
+            throw std::bad_alloc();
+        std::uintptr_t aligned =
+            (reinterpret_cast<std::uintptr_t>(raw) + align) & ~(align - 1);
+        reinterpret_cast<void **>(aligned)[-1] = raw;
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes,
+                       std::size_t align) override {
+        std::lock_guard<Lock> guard(lock_);
+        if (align <= alignment) {
+            mm_free_sized(p, bytes ? bytes : 1);
+            return;
+        }
+        mm_free_sized(static_cast<void **>(p)[-1], bytes + align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override {
+        return this == &other;
+    }
+};
+
+using resource = basic_resource<std::mutex>;
+using unsynchronized_resource = basic_resource<null_lock>;
+
+/* The process-wide resource used by mm::allocator */
+inline resource *default_resource() {
+    static resource r;
+    return &r;
+}
+
+/* ----------------------------------------------------------------------------
+ * Class: allocator
+ * ----------------------------------------------------------------------------
+ * Description:
+ * Stateless standard Allocator over 'default_resource()'.
+ * ----------------------------------------------------------------------------
+ */
+template <class T>
+class allocator {
+public:
+    using value_type = T;
+
+    allocator() noexcept = default;
+    template <class U>
+    allocator(const allocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T *>(
+            default_resource()->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        default_resource()->deallocate(p, n * sizeof(T), alignof(T));
+    }
+};
+
+template <class T, class U>
+bool operator==(const allocator<T> &, const allocator<U> &) noexcept {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const allocator<T> &, const allocator<U> &) noexcept {
+    return false;
+}
+
+} /* namespace mm */
+
+#endif /* __MM_ALLOCATOR_HPP__ */
@@ -0,0 +1,130 @@
+/* -----------------------------------------------------------------------------
+ * File: mm_bench.cpp
+ * Name: Sudhir Kumar Vijay
+ * Andrew ID: svijay@andrew.cmu.edu
+ * -----------------------------------------------------------------------------
+ * Container churn benchmark for the C++ adapters in mm_allocator.hpp. Each
+ * workload runs with the default allocator, with mm::allocator<T>, and as a
+ * pmr container on the default new/delete resource and on
+ * mm::unsynchronized_resource. The mm heap is bounded by MAX_HEAP, so the
+ * live set of every workload is kept to a few MB.
+ *
+ * Build with 'make mmbench', run as './mmbench [rounds]'.
+ * -----------------------------------------------------------------------------
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "mm_allocator.hpp"
+
+#define VEC_COUNT   64      /* Vectors grown side by side */
+#define VEC_LEN     4096    /* Elements pushed into each vector per round */
+#define MAP_KEYS    (1<<16) /* Key space for the map workloads */
+#define MAP_OPS     (1<<18) /* Inserts/erases per round */
+
+static unsigned rounds = 30;
+static volatile unsigned long sink;
+
+/* Times 'rounds' calls of 'body', returns nanoseconds per round */
+static double run(const std::function<void()> &body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < rounds; r++)
+        body();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count()
+        / rounds;
+}
+
+/* Interleaved push_back into many vectors, so their buffers keep moving */
+template <class Vec, class... Args>
+static void vector_churn(Args &&...args)
+{
+    std::vector<Vec> vecs;
+    for (int i = 0; i < VEC_COUNT; i++)
+        vecs.emplace_back(args...);
+    for (int n = 0; n < VEC_LEN; n++)
+        for (auto &v : vecs)
+            v.push_back(n);
+    for (auto &v : vecs)
+        sink += v.size();
+}
+
+/* Random inserts and erases over a fixed key space */
+template <class Map, class... Args>
+static void map_churn(Args &&...args)
+{
+    Map m(args...);
+    unsigned seed = 15213;
+    for (int i = 0; i < MAP_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned key = (seed >> 8) % MAP_KEYS;
+        if (seed & 0x10000)
+            m[key] = i;
+        else
+            m.erase(key);
+    }
+    sink += m.size();
+}
+
+template <class T>
+using mm_vector = std::vector<T, mm::allocator<T>>;
+template <class K, class V>
+using mm_map = std::map<K, V, std::less<K>,
+                        mm::allocator<std::pair<const K, V>>>;
+template <class K, class V>
+using mm_umap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                   mm::allocator<std::pair<const K, V>>>;
+
+static void report(const char *name, double std_ns, double mm_ns,
+                   double pmr_ns, double pmr_mm_ns)
+{
+    printf("%-14s %10.2f %10.2f %10.2f %10.2f\n", name, std_ns / 1e6,
+           mm_ns / 1e6, pmr_ns / 1e6, pmr_mm_ns / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        rounds = atoi(argv[1]);
+    if (rounds == 0)
+        rounds = 1;
+
+    mm::unsynchronized_resource mm_res;
+    std::pmr::memory_resource *nd_res = std::pmr::new_delete_resource();
+
+    printf("ms per round, %u rounds\n", rounds);
+    printf("%-14s %10s %10s %10s %10s\n", "workload", "std", "mm",
+           "pmr", "pmr+mm");
+
+    report("vector",
+           run([] { vector_churn<std::vector<int>>(); }),
+           run([] { vector_churn<mm_vector<int>>(); }),
+           run([&] { vector_churn<std::pmr::vector<int>>(nd_res); }),
+           run([&] { vector_churn<std::pmr::vector<int>>(&mm_res); }));
+
+    report("unordered_map",
+           run([] { map_churn<std::unordered_map<unsigned, int>>(); }),
+           run([] { map_churn<mm_umap<unsigned, int>>(); }),
+           run([&] {
+               map_churn<std::pmr::unordered_map<unsigned, int>>(nd_res);
+           }),
+           run([&] {
+               map_churn<std::pmr::unordered_map<unsigned, int>>(&mm_res);
+           }));
+
+    report("map",
+           run([] { map_churn<std::map<unsigned, int>>(); }),
+           run([] { map_churn<mm_map<unsigned, int>>(); }),
+           run([&] { map_churn<std::pmr::map<unsigned, int>>(nd_res); }),
+           run([&] { map_churn<std::pmr::map<unsigned, int>>(&mm_res); }));
+
+    return 0;
+}